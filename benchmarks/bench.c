@@ -0,0 +1,199 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/*
+ * Usage: ./bench [benchmark...]
+ *
+ * Without arguments every case runs. The results go to stdout (see bench.h for
+ * the format), errors to stderr, and the exit status is 1 if a case failed
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+
+struct bench_case {
+	const char *name;
+	unsigned int param;
+	unsigned long samples;
+	void (*run)(unsigned int param);
+};
+
+static const struct bench_case bench_cases[] = {
+	{"clock_overhead", 0, 100000, bench_clock_overhead},
+	{"yield_round_trip", 2, 100000, bench_yield_round_trip},
+	{"next_id", 1, 100000, bench_next_id},
+	{"next_id", 16, 100000, bench_next_id},
+	{"next_id", 64, 100000, bench_next_id},
+	{"next_id", 250, 100000, bench_next_id},
+	{"sleep_wake_latency", 1, 1000, bench_sleep_wake_latency},
+	{"tick_isr_sleeping", 1, 50000, bench_tick_isr_sleeping},
+	{"tick_isr_sleeping", 16, 50000, bench_tick_isr_sleeping},
+	{"tick_isr_sleeping", 64, 50000, bench_tick_isr_sleeping},
+	{"tick_isr_sleeping", 250, 50000, bench_tick_isr_sleeping},
+	{"tick_isr_wake_all", 1, 10000, bench_tick_isr_wake_all},
+	{"tick_isr_wake_all", 16, 10000, bench_tick_isr_wake_all},
+	{"tick_isr_wake_all", 64, 10000, bench_tick_isr_wake_all},
+	{"tick_isr_wake_all", 250, 10000, bench_tick_isr_wake_all},
+	{"mutex_uncontended", 1, 1000, bench_mutex_uncontended},
+	{"mutex_contended", 2, 1000, bench_mutex_contended},
+	{"queue_item", 2, 1000, bench_queue_item},
+};
+
+static int bench_compare(const void *a, const void *b);
+static int bench_selected(const char *name, int argc, char **argv);
+static int bench_run_case(const struct bench_case *bench_case);
+
+static struct kthread_t bench_threads[BENCH_MAX_THREADS];
+static uint8_t bench_stacks[BENCH_MAX_THREADS][BENCH_STACK_SIZE];
+static double bench_samples[BENCH_MAX_SAMPLES];
+static unsigned long bench_samples_count;
+static const struct bench_case *bench_current;
+
+uint64_t
+bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+int
+bench_thread_create(void (*func)(void *), void *args, uint8_t priority)
+{
+	static size_t used;
+	int id;
+
+	if (used == BENCH_MAX_THREADS) {
+		fprintf(stderr, "%s: too many threads\n", bench_current->name);
+		exit(1);
+	}
+
+	id = kthread_create_static(func, args, bench_stacks[used],
+				   BENCH_STACK_SIZE, priority);
+	if (id <= 0) {
+		fprintf(stderr, "%s: thread problem\n", bench_current->name);
+		exit(1);
+	}
+	used++;
+
+	return id;
+}
+
+void
+bench_start(void)
+{
+	kscheduler_start();
+	fprintf(stderr, "%s: start scheduler problem\n", bench_current->name);
+	exit(1);
+}
+
+void
+bench_sample(double ns)
+{
+	unsigned long n;
+
+	bench_samples[bench_samples_count++] = ns;
+	if (bench_samples_count < bench_current->samples)
+		return;
+
+	n = bench_samples_count;
+	qsort(bench_samples, n, sizeof(bench_samples[0]), bench_compare);
+	printf("%s\t%u\t%lu\t%.1f\t%.1f\t%.1f\n", bench_current->name,
+	       bench_current->param, n, bench_samples[n * 50 / 100],
+	       bench_samples[n * 99 / 100], bench_samples[n - 1]);
+	exit(0);
+}
+
+int
+main(int argc, char **argv)
+{
+	size_t i;
+	int failed;
+
+	printf("benchmark\tparam\tsamples\tp50_ns\tp99_ns\tmax_ns\n");
+
+	failed = 0;
+	for (i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++) {
+		if (bench_selected(bench_cases[i].name, argc, argv))
+			failed |= bench_run_case(&bench_cases[i]);
+	}
+
+	return failed;
+}
+
+static int
+bench_compare(const void *a, const void *b)
+{
+	double x, y;
+
+	x = *(const double *)a;
+	y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int
+bench_selected(const char *name, int argc, char **argv)
+{
+	int i;
+
+	if (argc < 2)
+		return 1;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(name, argv[i]))
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Runs the case in a child and waits for it
+ *
+ * @returns 0 if the child printed its result and 1 otherwise
+ */
+static int
+bench_run_case(const struct bench_case *bench_case)
+{
+	pid_t pid;
+	int status;
+
+	/* the child would print what is buffered again */
+	fflush(stdout);
+
+	pid = fork();
+	if (pid < 0) {
+		perror("fork");
+		return 1;
+	}
+	if (pid == 0) {
+		bench_current = bench_case;
+		if (kprovide_threads_array(bench_threads, BENCH_MAX_THREADS)) {
+			fprintf(stderr, "%s: threads array problem\n",
+				bench_case->name);
+			exit(1);
+		}
+		bench_case->run(bench_case->param);
+		fprintf(stderr, "%s: returned\n", bench_case->name);
+		exit(1);
+	}
+
+	if (waitpid(pid, &status, 0) < 0) {
+		perror("waitpid");
+		return 1;
+	}
+
+	return !WIFEXITED(status) || WEXITSTATUS(status);
+}
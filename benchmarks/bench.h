@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * The benchmark suite runs every case in a forked child, because the scheduler
+ * can only be started once per process. A case creates its threads with
+ * bench_thread_create, starts them with bench_start and hands every measured
+ * time to bench_sample. When the case has enough samples, the child prints one
+ * tab separated line and exits:
+ *
+ * benchmark	param	samples	p50_ns	p99_ns	max_ns
+ */
+
+#ifndef STATIC_RTOS_BENCH_H
+#define STATIC_RTOS_BENCH_H
+
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+
+/* 250 threads plus the thread that measures */
+#define BENCH_MAX_THREADS 251
+#define BENCH_STACK_SIZE 16384
+#define BENCH_MAX_SAMPLES 100000
+
+/**
+ * @returns CLOCK_MONOTONIC in ns
+ */
+uint64_t bench_now_ns(void);
+
+/**
+ * Same as kthread_create_static, with a stack from the suite. Exits the child
+ * on failure
+ */
+int bench_thread_create(void (*func)(void *), void *args, uint8_t priority);
+
+/**
+ * Starts the scheduler. Doesn't return
+ */
+void bench_start(void);
+
+/**
+ * Records one measurement of the current case. The one that completes the case
+ * prints the result and exits the child
+ *
+ * @param ns The measured time, in ns. Cases that time a batch of operations
+ *	     pass the time of one operation
+ */
+void bench_sample(double ns);
+
+/* the cases, param is the thread count for the ones that vary it */
+void bench_clock_overhead(unsigned int param);
+void bench_yield_round_trip(unsigned int param);
+void bench_next_id(unsigned int param);
+void bench_sleep_wake_latency(unsigned int param);
+void bench_tick_isr_sleeping(unsigned int param);
+void bench_tick_isr_wake_all(unsigned int param);
+void bench_mutex_uncontended(unsigned int param);
+void bench_mutex_contended(unsigned int param);
+void bench_queue_item(unsigned int param);
+
+#endif /* #ifndef STATIC_RTOS_BENCH_H */
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/*
+ * The throughput cases time batches of operations and a sample is the time of
+ * one operation in a batch
+ *
+ * mutex_uncontended: one thread takes and gives a mutex nobody else uses
+ * mutex_contended: two threads of the same priority take the mutex and yield
+ *		    while holding it, so every take blocks and every give
+ *		    hands the mutex over
+ * queue_item: a thread sends 4 byte items through a queue of 16 to a thread of
+ *	       the same priority
+ */
+#include <static_rtos/kernel/mutex.h>
+#include <static_rtos/kernel/queue.h>
+
+#include "bench.h"
+
+#define MUTEX_BATCH 10000
+#define CONTENDED_BATCH 1000
+#define QUEUE_BATCH 1000
+#define QUEUE_CAPACITY 16
+
+static void uncontended_thread(void *args);
+static void contending_thread(void *args);
+static void sending_thread(void *args);
+static void receiving_thread(void *args);
+
+static struct kmutex_t mutex;
+static unsigned long contended_pairs;
+static uint64_t batch_start;
+static struct kqueue_t queue;
+static uint32_t queue_buffer[QUEUE_CAPACITY];
+
+void
+bench_mutex_uncontended(unsigned int param)
+{
+	(void)param;
+
+	kmutex_create(&mutex);
+	bench_thread_create(uncontended_thread, NULL, 1);
+	bench_start();
+}
+
+void
+bench_mutex_contended(unsigned int param)
+{
+	(void)param;
+
+	kmutex_create(&mutex);
+	bench_thread_create(contending_thread, NULL, 1);
+	bench_thread_create(contending_thread, NULL, 1);
+	bench_start();
+}
+
+void
+bench_queue_item(unsigned int param)
+{
+	(void)param;
+
+	kqueue_create(&queue, queue_buffer, sizeof(queue_buffer[0]),
+		      QUEUE_CAPACITY);
+	bench_thread_create(sending_thread, NULL, 1);
+	bench_thread_create(receiving_thread, NULL, 1);
+	bench_start();
+}
+
+static void
+uncontended_thread(void *args)
+{
+	uint64_t start;
+	unsigned long i;
+
+	(void)args;
+
+	while (1) {
+		start = bench_now_ns();
+		for (i = 0; i < MUTEX_BATCH; i++) {
+			kmutex_take(&mutex, KWAIT_FOREVER);
+			kmutex_give(&mutex);
+		}
+		bench_sample((double)(bench_now_ns() - start) / MUTEX_BATCH);
+	}
+}
+
+static void
+contending_thread(void *args)
+{
+	uint64_t now;
+
+	(void)args;
+
+	while (1) {
+		kmutex_take(&mutex, KWAIT_FOREVER);
+		kyield();
+		kmutex_give(&mutex);
+
+		if (++contended_pairs % CONTENDED_BATCH == 0) {
+			now = bench_now_ns();
+			if (batch_start)
+				bench_sample((double)(now - batch_start) /
+					     CONTENDED_BATCH);
+			batch_start = now;
+		}
+	}
+}
+
+static void
+sending_thread(void *args)
+{
+	uint32_t item;
+
+	(void)args;
+
+	item = 0;
+	while (1) {
+		kqueue_send(&queue, &item, KWAIT_FOREVER);
+		item++;
+	}
+}
+
+static void
+receiving_thread(void *args)
+{
+	uint32_t item;
+	uint64_t start;
+	unsigned long i;
+
+	(void)args;
+
+	while (1) {
+		start = bench_now_ns();
+		for (i = 0; i < QUEUE_BATCH; i++)
+			kqueue_receive(&queue, &item, KWAIT_FOREVER);
+		bench_sample((double)(bench_now_ns() - start) / QUEUE_BATCH);
+	}
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/*
+ * clock_overhead: two back to back clock reads, to subtract from the other
+ *		   single event cases
+ * yield_round_trip: two threads of the same priority yield to each other. A
+ *		     sample is the time for the other thread to run and yield
+ *		     back, so two switches
+ * next_id: one thread with the highest priority yields, so kyield only picks
+ *	    the next thread and doesn't switch. param threads with lower,
+ *	    spread out priorities are READY too
+ */
+#include "bench.h"
+
+static void yield_measuring_thread(void *args);
+static void yield_other_thread(void *args);
+static void ready_thread(void *args);
+
+void
+bench_clock_overhead(unsigned int param)
+{
+	uint64_t start;
+
+	(void)param;
+
+	while (1) {
+		start = bench_now_ns();
+		bench_sample(bench_now_ns() - start);
+	}
+}
+
+void
+bench_yield_round_trip(unsigned int param)
+{
+	(void)param;
+
+	bench_thread_create(yield_measuring_thread, NULL, 1);
+	bench_thread_create(yield_other_thread, NULL, 1);
+	bench_start();
+}
+
+void
+bench_next_id(unsigned int param)
+{
+	unsigned int i;
+
+	for (i = 0; i < param; i++)
+		bench_thread_create(ready_thread, NULL, 1 + i % 250);
+	bench_thread_create(yield_measuring_thread, NULL, 254);
+	bench_start();
+}
+
+static void
+yield_measuring_thread(void *args)
+{
+	uint64_t start;
+
+	(void)args;
+
+	while (1) {
+		start = bench_now_ns();
+		kyield();
+		bench_sample(bench_now_ns() - start);
+	}
+}
+
+static void
+yield_other_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		kyield();
+}
+
+static void
+ready_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		;
+}
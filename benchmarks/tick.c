@@ -0,0 +1,126 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/*
+ * sleep_wake_latency: a thread sleeps one tick at a time with the tick
+ *		       interrupt on while a lower priority thread notes the
+ *		       time all the time. A sample is the time from the last
+ *		       note to the woken thread running: signal delivery, the
+ *		       tick isr and the switch
+ * tick_isr_sleeping: kincrease_tickcount with param threads sleeping far
+ *		      in the future, so no thread wakes up
+ * tick_isr_wake_all: kincrease_tickcount when param threads sleeping one tick
+ *		      wake up at once
+ *
+ * The tick_isr cases call kincrease_tickcount from a thread without the tick
+ * interrupt, so nothing else runs meanwhile
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#define FAR_SLEEP_TICKS 1000000
+
+static void sleeping_thread(void *args);
+static void spinning_thread(void *args);
+static void far_sleeping_thread(void *args);
+static void short_sleeping_thread(void *args);
+static void tick_measuring_thread(void *args);
+
+static volatile uint64_t spin_ns;
+
+void
+bench_sleep_wake_latency(unsigned int param)
+{
+	(void)param;
+
+	bench_thread_create(sleeping_thread, NULL, 2);
+	bench_thread_create(spinning_thread, NULL, 1);
+	if (kenable_tick_interrupt()) {
+		fprintf(stderr, "sleep_wake_latency: interrupt problem\n");
+		exit(1);
+	}
+	bench_start();
+}
+
+void
+bench_tick_isr_sleeping(unsigned int param)
+{
+	unsigned int i;
+
+	for (i = 0; i < param; i++)
+		bench_thread_create(far_sleeping_thread, NULL, 2);
+	bench_thread_create(tick_measuring_thread, NULL, 1);
+	bench_start();
+}
+
+void
+bench_tick_isr_wake_all(unsigned int param)
+{
+	unsigned int i;
+
+	for (i = 0; i < param; i++)
+		bench_thread_create(short_sleeping_thread, NULL, 2);
+	bench_thread_create(tick_measuring_thread, NULL, 1);
+	bench_start();
+}
+
+static void
+sleeping_thread(void *args)
+{
+	(void)args;
+
+	while (1) {
+		ksleep_for_ticks(1);
+		bench_sample(bench_now_ns() - spin_ns);
+	}
+}
+
+static void
+spinning_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		spin_ns = bench_now_ns();
+}
+
+static void
+far_sleeping_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		ksleep_for_ticks(FAR_SLEEP_TICKS);
+}
+
+static void
+short_sleeping_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		ksleep_for_ticks(1);
+}
+
+/**
+ * Runs after every other thread went to sleep. The woken threads have a higher
+ * priority, so kyield runs them until they sleep again
+ */
+static void
+tick_measuring_thread(void *args)
+{
+	uint64_t start;
+
+	(void)args;
+
+	while (1) {
+		start = bench_now_ns();
+		kincrease_tickcount();
+		bench_sample(bench_now_ns() - start);
+		kyield();
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * A runaway thread at the highest priority spins without ever giving up the
+ * cpu, above a control loop that runs every 5 ticks. Built as budget
+ * (-DSTATIC_RTOS_THREAD_BUDGET) the runaway thread may only run for 3 ticks
+ * every 10 at its priority before it is throttled below the control loop,
+ * which keeps its deadlines. Built as unlimited, the control loop never runs.
+ * A thread above both prints the counters after 500 ticks
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/periodic.h>
+
+#define RUN_TICKS 500
+
+void report_thread(void *args);
+void runaway_thread(void *args);
+void control_thread(void *args);
+
+static struct kperiodic_t control_loop;
+static volatile unsigned long runaway_spins;
+
+void
+report_thread(void *args)
+{
+	(void)args;
+
+	ksleep_for_ticks(RUN_TICKS);
+	printf("control: %lu periods, %lu missed, max jitter %lu ticks\n",
+	       (unsigned long)control_loop.periods,
+	       (unsigned long)control_loop.missed,
+	       (unsigned long)control_loop.max_jitter);
+	printf("runaway: %lu spins\n", runaway_spins);
+	exit(0);
+}
+
+void
+runaway_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		runaway_spins++;
+}
+
+void
+control_thread(void *args)
+{
+	kticktype_t start;
+
+	(void)args;
+
+	kperiodic_start(&control_loop, 5);
+	while (1) {
+		/* a tick of work */
+		start = kget_tickcount();
+		while (kget_tickcount() == start)
+			;
+		kperiodic_wait(&control_loop);
+	}
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[3];
+	static uint8_t stacks[3][16384];
+	int runaway_id;
+
+	if (kprovide_threads_array(threads, 3))
+		printf("threads array problem\n");
+
+	runaway_id = kthread_create_static(runaway_thread, NULL, stacks[0],
+					   sizeof(stacks[0]), 3);
+	if (runaway_id <= 0 ||
+	    kthread_create_static(control_thread, NULL, stacks[1],
+				  sizeof(stacks[1]), 2) <= 0 ||
+	    kthread_create_static(report_thread, NULL, stacks[2],
+				  sizeof(stacks[2]), 4) <= 0)
+		printf("thread problem\n");
+
+#ifdef STATIC_RTOS_THREAD_BUDGET
+	if (kthread_set_budget(runaway_id, 3, 10, 1))
+		printf("budget problem\n");
+#endif
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
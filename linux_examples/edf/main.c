@@ -0,0 +1,119 @@
+/*
+ * Two periodic threads: one needs 4 ticks of cpu every 10 ticks, the other 7
+ * every 14, which uses 90% of the cpu. Built as rm, they have rate monotonic
+ * priorities (the shorter period runs first) and the slower one misses
+ * deadlines even though the cpu isn't full. Built as edf
+ * (-DSTATIC_RTOS_EDF_PRIORITY=1) both are in the EDF band and none are missed.
+ * The work is measured with the run time statistics, so the time a thread
+ * spends preempted doesn't count. A higher priority thread prints the counters
+ * after 420 ticks
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/periodic.h>
+
+#ifdef STATIC_RTOS_EDF_PRIORITY
+#define FAST_PRIORITY STATIC_RTOS_EDF_PRIORITY
+#define SLOW_PRIORITY STATIC_RTOS_EDF_PRIORITY
+#else
+#define FAST_PRIORITY 2
+#define SLOW_PRIORITY 1
+#endif
+
+#define RUN_TICKS 420
+/* port_timestamp counts nanoseconds on linux */
+#define TICK_TIMESTAMPS ((uint32_t)STATIC_RTOS_LINUX_TICK_NS)
+
+struct task_t {
+	const char *name;
+	kticktype_t period;
+	kticktype_t work_ticks;
+	int id;
+	struct kperiodic_t loop;
+};
+
+void periodic_thread(void *args);
+void report_thread(void *args);
+static uint32_t run_time(int id);
+
+static struct task_t tasks[2] = {
+	{ "fast", 10, 4, 0, { 0 } },
+	{ "slow", 14, 7, 0, { 0 } }
+};
+
+/* the run time of the thread, so the time it spends preempted doesn't count
+ * as work done
+ */
+static uint32_t
+run_time(int id)
+{
+	struct kthread_stats_t stats[4];
+
+	kthread_get_stats(stats, 4, NULL);
+	return stats[id].run_time;
+}
+
+void
+periodic_thread(void *args)
+{
+	struct task_t *task;
+	uint32_t start;
+
+	task = args;
+	kperiodic_start(&task->loop, task->period);
+	while (1) {
+		start = run_time(task->id);
+		while (run_time(task->id) - start <
+		       task->work_ticks * TICK_TIMESTAMPS)
+			;
+		kperiodic_wait(&task->loop);
+	}
+}
+
+void
+report_thread(void *args)
+{
+	int i;
+
+	(void)args;
+
+	ksleep_for_ticks(RUN_TICKS);
+	for (i = 0; i < 2; i++)
+		printf("%s: %lu periods, %lu missed, max jitter %lu ticks\n",
+		       tasks[i].name, (unsigned long)tasks[i].loop.periods,
+		       (unsigned long)tasks[i].loop.missed,
+		       (unsigned long)tasks[i].loop.max_jitter);
+	exit(0);
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[3];
+	static uint8_t stacks[3][16384];
+
+	if (kprovide_threads_array(threads, 3))
+		printf("threads array problem\n");
+
+	if (kthread_create_static(report_thread, NULL, stacks[0],
+				  sizeof(stacks[0]), 3) <= 0)
+		printf("thread problem\n");
+	tasks[0].id = kthread_create_static(periodic_thread, &tasks[0],
+					    stacks[1], sizeof(stacks[1]),
+					    FAST_PRIORITY);
+	tasks[1].id = kthread_create_static(periodic_thread, &tasks[1],
+					    stacks[2], sizeof(stacks[2]),
+					    SLOW_PRIORITY);
+	if (tasks[0].id <= 0 || tasks[1].id <= 0)
+		printf("thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
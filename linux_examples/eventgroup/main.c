@@ -0,0 +1,119 @@
+/*
+ * Two threads set bits of a event group, a sensor every 30 ticks and a button
+ * every 70 ticks. One thread waits for any of the two events, another one
+ * waits until both happened since its last wakeup. Each event sets two bits,
+ * one for each waiter, and both waiters clear their bits when they wake up.
+ * While they wait the threads are BLOCKED, so nothing runs between the events
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/eventgroup.h>
+
+#define SENSOR_BIT 0x1
+#define BUTTON_BIT 0x2
+#define SENSOR_ALL_BIT 0x4
+#define BUTTON_ALL_BIT 0x8
+#define UNUSED_BIT 0x10
+
+void any_thread(void *args);
+void all_thread(void *args);
+void setter_thread(void *args);
+
+struct setter_t {
+	keventbits_t bit;
+	uint16_t period;
+};
+
+static struct keventgroup_t group;
+
+void
+any_thread(void *args)
+{
+	keventbits_t bits;
+	int i;
+
+	(void)args;
+
+	for (i = 0; i < 10; i++) {
+		if (keventgroup_wait(&group, SENSOR_BIT | BUTTON_BIT,
+				     KEVENT_WAIT_ANY | KEVENT_CLEAR_ON_EXIT,
+				     KWAIT_FOREVER, &bits))
+			printf("wait problem\n");
+		printf("any:%s%s\n", bits & SENSOR_BIT ? " sensor" : "",
+		       bits & BUTTON_BIT ? " button" : "");
+	}
+
+	/* nobody sets UNUSED_BIT */
+	if (keventgroup_wait(&group, UNUSED_BIT, KEVENT_WAIT_ALL, 50, &bits))
+		printf("any: timeout, bits 0x%x\n", (unsigned int)bits);
+	exit(0);
+}
+
+void
+all_thread(void *args)
+{
+	(void)args;
+
+	while (1) {
+		if (keventgroup_wait(&group, SENSOR_ALL_BIT | BUTTON_ALL_BIT,
+				     KEVENT_WAIT_ALL | KEVENT_CLEAR_ON_EXIT,
+				     KWAIT_FOREVER, NULL))
+			printf("wait problem\n");
+		printf("all: sensor and button\n");
+	}
+}
+
+void
+setter_thread(void *args)
+{
+	struct setter_t *setter;
+
+	setter = args;
+
+	while (1) {
+		ksleep_for_ticks(setter->period);
+		if (keventgroup_set(&group, setter->bit))
+			printf("set problem\n");
+	}
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[4];
+	static uint8_t any_thread_stack[16384];
+	static uint8_t all_thread_stack[16384];
+	static uint8_t sensor_thread_stack[16384];
+	static uint8_t button_thread_stack[16384];
+	static struct setter_t sensor = { SENSOR_BIT | SENSOR_ALL_BIT, 30 };
+	static struct setter_t button = { BUTTON_BIT | BUTTON_ALL_BIT, 70 };
+
+	if (kprovide_threads_array(threads, 4))
+		printf("threads array problem\n");
+
+	if (keventgroup_create(&group, 0))
+		printf("event group problem\n");
+
+	if (kthread_create_static(any_thread, NULL, any_thread_stack,
+				  sizeof(any_thread_stack), 3) <= 0)
+		printf("any_thread problem\n");
+	if (kthread_create_static(all_thread, NULL, all_thread_stack,
+				  sizeof(all_thread_stack), 4) <= 0)
+		printf("all_thread problem\n");
+	if (kthread_create_static(setter_thread, &sensor, sensor_thread_stack,
+				  sizeof(sensor_thread_stack), 2) <= 0)
+		printf("sensor_thread problem\n");
+	if (kthread_create_static(setter_thread, &button, button_thread_stack,
+				  sizeof(button_thread_stack), 2) <= 0)
+		printf("button_thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -38,10 +38,10 @@ main(void)
 		printf("threads array problem\n");
 
 	if (kthread_create_static(thread1, NULL, thread1_stack,
-				  sizeof(thread1_stack), 1))
+				  sizeof(thread1_stack), 1) <= 0)
 		printf("thread1 problem\n");
 	if (kthread_create_static(thread2, NULL, thread2_stack,
-				  sizeof(thread2_stack), 1))
+				  sizeof(thread2_stack), 1) <= 0)
 		printf("thread2 problem\n");
 
 	if (kscheduler_start())
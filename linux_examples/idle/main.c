@@ -0,0 +1,81 @@
+/*
+ * A thread does a little work every 10 ticks and sleeps the rest of the time.
+ * The idle thread runs on its own stack, calls the idle hook and then sleeps
+ * the process until the next signal instead of spinning, so the cpu time
+ * printed at the end is a small part of the time that passed
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <static_rtos/kernel/scheduler.h>
+
+#define PERIODS 100
+#define PERIOD_TICKS 10
+
+void worker_thread(void *args);
+static void idle_hook(void);
+
+static volatile unsigned long idle_hook_calls;
+
+static void
+idle_hook(void)
+{
+	idle_hook_calls++;
+}
+
+void
+worker_thread(void *args)
+{
+	struct timespec start, end;
+	volatile unsigned long i;
+	int period;
+
+	(void)args;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (period = 0; period < PERIODS; period++) {
+		for (i = 0; i < 100000; i++)
+			;
+		ksleep_for_ticks(PERIOD_TICKS);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	printf("%d ticks in %.0f ms, %.0f ms of cpu time\n",
+	       PERIODS * PERIOD_TICKS,
+	       (end.tv_sec - start.tv_sec) * 1e3 +
+	       (end.tv_nsec - start.tv_nsec) / 1e6,
+	       clock() * 1e3 / CLOCKS_PER_SEC);
+	printf("the idle hook was called %lu times\n", idle_hook_calls);
+
+	exit(0);
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[1];
+	static uint8_t idle_stack[16384];
+	static uint8_t worker_stack[16384];
+
+	if (kprovide_threads_array(threads, 1))
+		printf("threads array problem\n");
+
+	if (kprovide_idle_thread_stack(idle_stack, sizeof(idle_stack)))
+		printf("idle stack problem\n");
+	kset_idle_hook(idle_hook);
+
+	if (kthread_create_static(worker_thread, NULL, worker_stack,
+				  sizeof(worker_stack), 1) <= 0)
+		printf("thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
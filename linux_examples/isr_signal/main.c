@@ -0,0 +1,192 @@
+/*
+ * A second POSIX timer stands in for a uart: its isr runs every 3 ms, gives a
+ * semaphore and notifies a thread. Both threads have a higher priority than a
+ * thread that spins all the time, so kisr_exit switches on exit and the woken
+ * thread runs right after the isr. After 200 interrupts the amount of
+ * events each thread got and the worst latency from the isr to the thread are
+ * printed
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/semaphore.h>
+
+#define EVENTS 200
+#define UART_PERIOD_NS 3000000L
+
+void semaphore_thread(void *args);
+void notified_thread(void *args);
+void spinning_thread(void *args);
+static void uart_isr(void);
+static void uart_signal_handler(int sig);
+static int start_uart_timer(void);
+static uint64_t now_ns(void);
+
+static struct ksemaphore_t rx_semaphore;
+static int notified_thread_id;
+static volatile unsigned long isr_count;
+static volatile uint64_t isr_ns;
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void
+uart_isr(void)
+{
+	if (isr_count == EVENTS)
+		return;
+
+	kisr_enter();
+
+	isr_count++;
+	isr_ns = now_ns();
+
+	if (ksemaphore_give_from_isr(&rx_semaphore, NULL))
+		printf("give problem\n");
+	if (kthread_notify_from_isr(notified_thread_id, NULL))
+		printf("notify problem\n");
+
+	/* the switch happens once, at the end of the isr */
+	kisr_exit();
+}
+
+static void
+uart_signal_handler(int sig)
+{
+	(void)sig;
+
+	port_linux_raise_interrupt(uart_isr);
+}
+
+static int
+start_uart_timer(void)
+{
+	struct sigaction sa;
+	struct sigevent sev;
+	struct itimerspec its;
+	timer_t timer;
+
+	sa.sa_handler = uart_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_NODEFER | SA_RESTART;
+	if (sigaction(SIGUSR1, &sa, NULL))
+		return 1;
+
+	sev.sigev_notify = SIGEV_SIGNAL;
+	sev.sigev_signo = SIGUSR1;
+	sev.sigev_value.sival_ptr = NULL;
+	if (timer_create(CLOCK_MONOTONIC, &sev, &timer))
+		return 1;
+
+	its.it_value.tv_sec = 0;
+	its.it_value.tv_nsec = UART_PERIOD_NS;
+	its.it_interval = its.it_value;
+
+	return timer_settime(timer, 0, &its, NULL);
+}
+
+void
+semaphore_thread(void *args)
+{
+	unsigned long events;
+	uint64_t latency, worst;
+
+	(void)args;
+
+	worst = 0;
+	for (events = 0; events < EVENTS; events++) {
+		if (ksemaphore_take(&rx_semaphore, KWAIT_FOREVER))
+			printf("take problem\n");
+		latency = now_ns() - isr_ns;
+		if (latency > worst)
+			worst = latency;
+	}
+
+	printf("semaphore: %lu events, worst latency %lu ns\n", events,
+	       (unsigned long)worst);
+	while (1)
+		ksleep_for_ticks(UINT16_MAX);
+}
+
+void
+notified_thread(void *args)
+{
+	unsigned long events;
+	uint64_t latency, worst;
+
+	(void)args;
+
+	worst = 0;
+	events = 0;
+	while (events < EVENTS) {
+		events += kthread_notify_take(1, KWAIT_FOREVER);
+		latency = now_ns() - isr_ns;
+		if (latency > worst)
+			worst = latency;
+	}
+
+	printf("notification: %lu events, worst latency %lu ns\n", events,
+	       (unsigned long)worst);
+	ksleep_for_ticks(10);
+	printf("%lu interrupts\n", isr_count);
+	exit(0);
+}
+
+void
+spinning_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		;
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[3];
+	static uint8_t semaphore_thread_stack[16384];
+	static uint8_t notified_thread_stack[16384];
+	static uint8_t spinning_thread_stack[16384];
+
+	if (kprovide_threads_array(threads, 3))
+		printf("threads array problem\n");
+
+	if (ksemaphore_create(&rx_semaphore, 0, UINT16_MAX))
+		printf("semaphore problem\n");
+
+	if (kthread_create_static(semaphore_thread, NULL,
+				  semaphore_thread_stack,
+				  sizeof(semaphore_thread_stack), 3) <= 0)
+		printf("semaphore_thread problem\n");
+	notified_thread_id = kthread_create_static(notified_thread, NULL,
+						   notified_thread_stack,
+						   sizeof(notified_thread_stack),
+						   2);
+	if (notified_thread_id <= 0)
+		printf("notified_thread problem\n");
+	if (kthread_create_static(spinning_thread, NULL, spinning_thread_stack,
+				  sizeof(spinning_thread_stack), 1) <= 0)
+		printf("spinning_thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+	if (start_uart_timer())
+		printf("uart timer problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Priority inversion: a low priority thread holds a mutex for 100 ms of
+ * spinning, a high priority thread waits for the mutex and a medium priority
+ * thread spins for 300 ms in the meantime. The low priority thread inherits
+ * the priority of the high one while it holds the mutex, so the medium thread
+ * can't preempt it and the high priority thread waits for less than 100 ms
+ * instead of 400 ms
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/mutex.h>
+
+void high_thread(void *args);
+void medium_thread(void *args);
+void low_thread(void *args);
+
+static struct kmutex_t mutex;
+
+static long
+elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000 +
+	       (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static void
+spin_ms(long ms)
+{
+	struct timespec start;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while (elapsed_ms(&start) < ms)
+		;
+}
+
+void
+high_thread(void *args)
+{
+	struct timespec start;
+	long ms;
+
+	(void)args;
+
+	ksleep_for_ticks(10);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (kmutex_take(&mutex, KWAIT_FOREVER))
+		printf("take problem\n");
+	ms = elapsed_ms(&start);
+	if (kmutex_give(&mutex))
+		printf("give problem\n");
+
+	printf("high priority thread waited %ld ms for the mutex\n", ms);
+	exit(0);
+}
+
+void
+medium_thread(void *args)
+{
+	(void)args;
+
+	ksleep_for_ticks(20);
+	spin_ms(300);
+
+	while (1)
+		ksleep_for_ticks(UINT16_MAX);
+}
+
+void
+low_thread(void *args)
+{
+	(void)args;
+
+	if (kmutex_take(&mutex, KWAIT_FOREVER))
+		printf("take problem\n");
+	spin_ms(100);
+	if (kmutex_give(&mutex))
+		printf("give problem\n");
+
+	while (1)
+		ksleep_for_ticks(UINT16_MAX);
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[3];
+	static uint8_t high_thread_stack[16384];
+	static uint8_t medium_thread_stack[16384];
+	static uint8_t low_thread_stack[16384];
+
+	if (kprovide_threads_array(threads, 3))
+		printf("threads array problem\n");
+
+	if (kmutex_create(&mutex))
+		printf("mutex problem\n");
+
+	if (kthread_create_static(high_thread, NULL, high_thread_stack,
+				  sizeof(high_thread_stack), 3) <= 0)
+		printf("high_thread problem\n");
+	if (kthread_create_static(medium_thread, NULL, medium_thread_stack,
+				  sizeof(medium_thread_stack), 2) <= 0)
+		printf("medium_thread problem\n");
+	if (kthread_create_static(low_thread, NULL, low_thread_stack,
+				  sizeof(low_thread_stack), 1) <= 0)
+		printf("low_thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * A control loop runs every 5 ticks with kperiodic_wait and a second loop
+ * does the same work with ksleep_for_ticks(5). A higher priority thread takes
+ * the cpu for 12 ticks every 100 ticks, which makes the control loop miss
+ * deadlines and start late. After 1000 ticks the loops print how many times
+ * they ran: the periodic one stays on its grid and accounts for all of the
+ * 200 periods, the relative one drifts by the time its work took
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/periodic.h>
+
+#define PERIOD 5
+#define RUN_TICKS 1000
+#define BURST_PERIOD 100
+#define BURST_TICKS 12
+
+void periodic_thread(void *args);
+void relative_thread(void *args);
+void burst_thread(void *args);
+static void work_for_ticks(kticktype_t ticks_count);
+
+static volatile unsigned long relative_runs;
+
+static void
+work_for_ticks(kticktype_t ticks_count)
+{
+	kticktype_t start;
+
+	start = kget_tickcount();
+	while (KTICK_DIFF(kget_tickcount(), start) <
+	       (ksignedticktype_t)ticks_count)
+		;
+}
+
+void
+periodic_thread(void *args)
+{
+	static struct kperiodic_t loop;
+	kticktype_t start;
+
+	(void)args;
+
+	kperiodic_start(&loop, PERIOD);
+	start = loop.release;
+	while (KTICK_DIFF(loop.release, start) < RUN_TICKS) {
+		work_for_ticks(1);
+		kperiodic_wait(&loop);
+	}
+
+	printf("periodic: %lu periods, %lu missed, max jitter %lu ticks, "
+	       "release %lu ticks after the start\n",
+	       (unsigned long)loop.periods, (unsigned long)loop.missed,
+	       (unsigned long)loop.max_jitter,
+	       (unsigned long)(loop.release - start));
+	printf("relative: %lu periods\n", relative_runs);
+	exit(0);
+}
+
+void
+relative_thread(void *args)
+{
+	(void)args;
+
+	while (1) {
+		work_for_ticks(1);
+		relative_runs++;
+		ksleep_for_ticks(PERIOD);
+	}
+}
+
+void
+burst_thread(void *args)
+{
+	(void)args;
+
+	while (1) {
+		ksleep_for_ticks(BURST_PERIOD - BURST_TICKS);
+		work_for_ticks(BURST_TICKS);
+	}
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[3];
+	static uint8_t stacks[3][16384];
+
+	if (kprovide_threads_array(threads, 3))
+		printf("threads array problem\n");
+
+	if (kthread_create_static(burst_thread, NULL, stacks[0],
+				  sizeof(stacks[0]), 3) <= 0 ||
+	    kthread_create_static(periodic_thread, NULL, stacks[1],
+				  sizeof(stacks[1]), 2) <= 0 ||
+	    kthread_create_static(relative_thread, NULL, stacks[2],
+				  sizeof(stacks[2]), 1) <= 0)
+		printf("thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
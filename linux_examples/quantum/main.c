@@ -0,0 +1,100 @@
+/*
+ * Three threads of the same priority spin without ever giving up the cpu. Built
+ * with -DSTATIC_RTOS_QUANTUM_TICKS=N they get turns of N ticks and share the
+ * cpu, the third one in turns of twice that. Without it one of them keeps the
+ * cpu until a higher priority monitor thread, which prints the share every
+ * thread got every 100 ticks, wakes up and the next one takes its turn
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+
+#define THREADS 4
+#define PERIOD_TICKS 100
+#define REPORTS 3
+
+void monitor_thread(void *args);
+void spinning_thread(void *args);
+
+static const char *names[THREADS + 1] = {
+	"idle", "monitor", "spin 1", "spin 2", "spin 3"
+};
+
+void
+monitor_thread(void *args)
+{
+	static struct kthread_stats_t before[THREADS + 1], after[THREADS + 1];
+	uint32_t total_before, total_after;
+	size_t count, i;
+	int report;
+
+	(void)args;
+
+	count = kthread_get_stats(before, THREADS + 1, &total_before);
+	for (report = 0; report < REPORTS; report++) {
+		ksleep_for_ticks(PERIOD_TICKS);
+		count = kthread_get_stats(after, THREADS + 1, &total_after);
+
+		printf("thread\tcpu\tswitches\n");
+		for (i = 0; i < count; i++) {
+			printf("%s\t%.1f%%\t%lu\n", names[i],
+			       100.0 * (after[i].run_time - before[i].run_time) /
+			       (total_after - total_before),
+			       (unsigned long)(after[i].switch_count -
+					       before[i].switch_count));
+			before[i] = after[i];
+		}
+		total_before = total_after;
+		printf("\n");
+	}
+
+	exit(0);
+}
+
+void
+spinning_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		;
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[THREADS];
+	static uint8_t stacks[THREADS][16384];
+	int id;
+
+	if (kprovide_threads_array(threads, THREADS))
+		printf("threads array problem\n");
+
+	if (kthread_create_static(monitor_thread, NULL, stacks[0],
+				  sizeof(stacks[0]), 2) <= 0 ||
+	    kthread_create_static(spinning_thread, NULL, stacks[1],
+				  sizeof(stacks[1]), 1) <= 0 ||
+	    kthread_create_static(spinning_thread, NULL, stacks[2],
+				  sizeof(stacks[2]), 1) <= 0)
+		printf("thread problem\n");
+	id = kthread_create_static(spinning_thread, NULL, stacks[3],
+				   sizeof(stacks[3]), 1);
+	if (id <= 0)
+		printf("thread problem\n");
+
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+	if (kthread_set_quantum(id, 2 * STATIC_RTOS_QUANTUM_TICKS))
+		printf("quantum problem\n");
+#else
+	(void)id;
+#endif
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * A producer sends numbered messages through a queue of 4 items faster than a
+ * lower priority consumer handles them, so the producer blocks whenever the
+ * queue is full. The consumer then waits 100 ticks for a message that never
+ * comes and reports the timeout
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/queue.h>
+
+#define MESSAGES 10
+#define QUEUE_CAPACITY 4
+
+struct message_t {
+	int number;
+	char text[12];
+};
+
+void producer_thread(void *args);
+void consumer_thread(void *args);
+
+static struct kqueue_t queue;
+
+void
+producer_thread(void *args)
+{
+	struct message_t message;
+	int i;
+
+	(void)args;
+
+	for (i = 1; i <= MESSAGES; i++) {
+		message.number = i;
+		snprintf(message.text, sizeof(message.text), "message %d", i);
+		if (kqueue_send(&queue, &message, KWAIT_FOREVER))
+			printf("send problem\n");
+		printf("sent %d, %u in the queue\n", i,
+		       (unsigned int)kqueue_count(&queue));
+	}
+
+	while (1)
+		ksleep_for_ticks(UINT16_MAX);
+}
+
+void
+consumer_thread(void *args)
+{
+	struct message_t message;
+
+	(void)args;
+
+	while (1) {
+		if (kqueue_receive(&queue, &message, 100)) {
+			printf("no message for 100 ticks\n");
+			exit(0);
+		}
+		printf("received %d: %s\n", message.number, message.text);
+		ksleep_for_ticks(10);
+	}
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[2];
+	static struct message_t queue_buffer[QUEUE_CAPACITY];
+	static uint8_t producer_thread_stack[16384];
+	static uint8_t consumer_thread_stack[16384];
+
+	if (kprovide_threads_array(threads, 2))
+		printf("threads array problem\n");
+
+	if (kqueue_create(&queue, queue_buffer, sizeof(queue_buffer[0]),
+			  QUEUE_CAPACITY))
+		printf("queue problem\n");
+
+	if (kthread_create_static(producer_thread, NULL, producer_thread_stack,
+				  sizeof(producer_thread_stack), 2) <= 0)
+		printf("producer_thread problem\n");
+	if (kthread_create_static(consumer_thread, NULL, consumer_thread_stack,
+				  sizeof(consumer_thread_stack), 1) <= 0)
+		printf("consumer_thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Measures the cost of kyield() as the number of threads grows. Every thread
+ * count is measured in a forked child because the scheduler can only be
+ * started once per process.
+ *
+ * equal: all of the threads are READY with the same priority and yield to each
+ *	  other in a round-robin
+ * two:	  two threads with a higher priority yield to each other while all of
+ *	  the others stay READY with a lower priority
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <static_rtos/kernel/scheduler.h>
+
+#define MAX_THREADS 250
+#define STACK_SIZE 16384
+#define WARMUP_YIELDS 10000
+#define MEASURED_YIELDS 200000
+
+void yield_thread(void *args);
+void idle_low_thread(void *args);
+static double run_child(size_t thread_count, int two_high);
+static uint64_t now_ns(void);
+
+static struct kthread_t threads[MAX_THREADS];
+static uint8_t stacks[MAX_THREADS][STACK_SIZE];
+static unsigned long yields;
+static uint64_t start_ns;
+static int result_fd;
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void
+yield_thread(void *args)
+{
+	double ns;
+
+	(void)args;
+
+	while (1) {
+		yields++;
+		if (yields == WARMUP_YIELDS) {
+			start_ns = now_ns();
+		} else if (yields == WARMUP_YIELDS + MEASURED_YIELDS) {
+			ns = (double)(now_ns() - start_ns) / MEASURED_YIELDS;
+			if (write(result_fd, &ns, sizeof(ns)) != sizeof(ns))
+				_exit(1);
+			_exit(0);
+		}
+		kyield();
+	}
+}
+
+void
+idle_low_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		kyield();
+}
+
+static double
+run_child(size_t thread_count, int two_high)
+{
+	int fds[2], status;
+	size_t i;
+	pid_t pid;
+	double ns;
+
+	if (pipe(fds))
+		return -1;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid < 0)
+		return -1;
+
+	if (pid == 0) {
+		close(fds[0]);
+		result_fd = fds[1];
+
+		if (kprovide_threads_array(threads, thread_count))
+			_exit(1);
+		for (i = 0; i < thread_count; i++) {
+			if (two_high && i >= 2) {
+				if (kthread_create_static(idle_low_thread, NULL,
+							  stacks[i], STACK_SIZE,
+							  1) <= 0)
+					_exit(1);
+			} else if (kthread_create_static(yield_thread, NULL,
+							 stacks[i], STACK_SIZE,
+							 2) <= 0) {
+				_exit(1);
+			}
+		}
+		kscheduler_start();
+		_exit(1);
+	}
+
+	close(fds[1]);
+	ns = -1;
+	if (read(fds[0], &ns, sizeof(ns)) != sizeof(ns))
+		ns = -1;
+	close(fds[0]);
+	waitpid(pid, &status, 0);
+
+	return ns;
+}
+
+int
+main(void)
+{
+	static const size_t counts[] = {2, 4, 8, 16, 32, 64, 128, 250};
+	size_t i;
+
+	printf("threads\tequal_ns_per_yield\ttwo_ns_per_yield\n");
+	for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+		printf("%u\t%.1f\t%.1f\n", (unsigned)counts[i],
+		       run_child(counts[i], 0), run_child(counts[i], 1));
+
+	return 0;
+}
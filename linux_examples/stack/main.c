@@ -0,0 +1,131 @@
+/*
+ * Measures how much stack the threads really use. A worker thread recurses a
+ * little deeper every time it runs and a monitor thread prints the high water
+ * mark of every stack next to its size. At the end, a thread with a stack that
+ * is too small for its recursion runs past it, into a guard area below it, and
+ * the overflow hook reports it when the thread is switched away from
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+
+#define THREADS 3
+#define STACK_SIZE 16384
+#define FRAME_SIZE 256
+#define REPORTS 4
+
+void monitor_thread(void *args);
+void worker_thread(void *args);
+void overflowing_thread(void *args);
+static unsigned int recurse(unsigned int depth);
+static void overflow_hook(int id);
+
+static uint8_t monitor_stack[STACK_SIZE];
+static uint8_t worker_stack[STACK_SIZE];
+static struct {
+	uint8_t guard[STACK_SIZE]; /* the stack grows down into it */
+	uint8_t stack[STACK_SIZE];
+} overflowing;
+static int overflowing_id;
+
+static unsigned int
+recurse(unsigned int depth)
+{
+	volatile uint8_t frame[FRAME_SIZE];
+	unsigned int i;
+
+	/* the whole frame is written, like a real buffer would be */
+	for (i = 0; i < FRAME_SIZE; i++)
+		frame[i] = (uint8_t)depth;
+	if (depth == 0)
+		return frame[0];
+
+	return recurse(depth - 1) + frame[FRAME_SIZE - 1];
+}
+
+static void
+overflow_hook(int id)
+{
+	printf("thread %d overflowed its stack\n", id);
+	exit(0);
+}
+
+void
+monitor_thread(void *args)
+{
+	static const char *names[THREADS] = { "monitor", "worker", "overflowing" };
+	int report, id;
+
+	(void)args;
+
+	for (report = 0; report < REPORTS; report++) {
+		ksleep_for_ticks(10);
+
+		printf("thread\t\tused\tsize\n");
+		for (id = 1; id <= THREADS; id++)
+			printf("%-11s\t%lu\t%d\n", names[id - 1],
+			       (unsigned long)kthread_stack_high_water(id),
+			       STACK_SIZE);
+		printf("\n");
+	}
+
+	kthread_unsuspend(overflowing_id);
+	while (1)
+		ksleep_for_ticks(10);
+}
+
+void
+worker_thread(void *args)
+{
+	unsigned int depth;
+
+	(void)args;
+
+	for (depth = 0; ; depth++) {
+		recurse(depth);
+		ksleep_for_ticks(10);
+	}
+}
+
+void
+overflowing_thread(void *args)
+{
+	(void)args;
+
+	kthread_suspend(0);
+
+	/* a few frames more than its stack holds */
+	recurse(STACK_SIZE / FRAME_SIZE + 8);
+	while (1)
+		kyield();
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[THREADS];
+
+	kset_stack_overflow_hook(overflow_hook);
+
+	if (kprovide_threads_array(threads, THREADS))
+		printf("threads array problem\n");
+
+	overflowing_id = -1;
+	if (kthread_create_static(monitor_thread, NULL, monitor_stack,
+				  sizeof(monitor_stack), 3) <= 0 ||
+	    kthread_create_static(worker_thread, NULL, worker_stack,
+				  sizeof(worker_stack), 2) <= 0 ||
+	    (overflowing_id = kthread_create_static(overflowing_thread, NULL,
+				overflowing.stack, sizeof(overflowing.stack),
+				1)) <= 0)
+		printf("thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
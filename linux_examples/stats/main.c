@@ -0,0 +1,128 @@
+/*
+ * Three threads of the same priority share the cpu: one spins without ever
+ * giving it up, one does a little work and yields, one does a little work and
+ * sleeps. The tick makes them take turns. A higher priority monitor thread
+ * takes a snapshot of the run time statistics every 200 ticks and prints the
+ * share of the cpu every thread got since the previous one, so the hog stands
+ * out
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+
+#define THREADS 4
+#define PERIOD_TICKS 200
+#define REPORTS 3
+
+void monitor_thread(void *args);
+void hog_thread(void *args);
+void yielding_thread(void *args);
+void sleeping_thread(void *args);
+static void work(unsigned long iterations);
+
+static const char *names[THREADS + 1] = {
+	"idle", "monitor", "hog", "yielding", "sleeping"
+};
+
+static void
+work(unsigned long iterations)
+{
+	volatile unsigned long i;
+
+	for (i = 0; i < iterations; i++)
+		;
+}
+
+void
+monitor_thread(void *args)
+{
+	static struct kthread_stats_t before[THREADS + 1], after[THREADS + 1];
+	uint32_t total_before, total_after, run_time;
+	size_t count, i;
+	int report;
+
+	(void)args;
+
+	count = kthread_get_stats(before, THREADS + 1, &total_before);
+	for (report = 0; report < REPORTS; report++) {
+		ksleep_for_ticks(PERIOD_TICKS);
+		count = kthread_get_stats(after, THREADS + 1, &total_after);
+
+		printf("thread\tcpu\tswitches\tlast run\n");
+		for (i = 0; i < count; i++) {
+			/* the counters wrap around, the differences don't */
+			run_time = after[i].run_time - before[i].run_time;
+			printf("%s\t%.1f%%\t%lu\t\t%lu us ago\n", names[i],
+			       100.0 * run_time / (total_after - total_before),
+			       (unsigned long)(after[i].switch_count -
+					       before[i].switch_count),
+			       (unsigned long)(after[i].since_last_run /
+					       (PORT_TIMESTAMP_HZ / 1000000)));
+			before[i] = after[i];
+		}
+		total_before = total_after;
+		printf("\n");
+	}
+
+	exit(0);
+}
+
+void
+hog_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		;
+}
+
+void
+yielding_thread(void *args)
+{
+	(void)args;
+
+	while (1) {
+		work(20000);
+		kyield();
+	}
+}
+
+void
+sleeping_thread(void *args)
+{
+	(void)args;
+
+	while (1) {
+		work(20000);
+		ksleep_for_ticks(1);
+	}
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[THREADS];
+	static uint8_t stacks[THREADS][16384];
+
+	if (kprovide_threads_array(threads, THREADS))
+		printf("threads array problem\n");
+
+	if (kthread_create_static(monitor_thread, NULL, stacks[0],
+				  sizeof(stacks[0]), 2) <= 0 ||
+	    kthread_create_static(hog_thread, NULL, stacks[1],
+				  sizeof(stacks[1]), 1) <= 0 ||
+	    kthread_create_static(yielding_thread, NULL, stacks[2],
+				  sizeof(stacks[2]), 1) <= 0 ||
+	    kthread_create_static(sleeping_thread, NULL, stacks[3],
+				  sizeof(stacks[3]), 1) <= 0)
+		printf("thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * A second POSIX timer stands in for a uart that receives a byte every
+ * 200 us. Its isr pushes the byte into a stream with a trigger level of 16, so
+ * the reading thread is woken once per 16 bytes instead of once per byte. At
+ * the end the amount of bytes, wakeups and lost bytes are printed
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/stream.h>
+
+#define BYTES 4096
+#define TRIGGER_LEVEL 16
+#define UART_PERIOD_NS 200000L
+
+void reader_thread(void *args);
+void spinning_thread(void *args);
+static void uart_isr(void);
+static void uart_signal_handler(int sig);
+static int start_uart_timer(void);
+
+static struct kstream_t rx_stream;
+static volatile unsigned long received, dropped;
+
+static void
+uart_isr(void)
+{
+	uint8_t byte;
+	int woken;
+
+	if (received + dropped == BYTES)
+		return;
+
+	byte = (uint8_t)(received + dropped);
+	woken = 0;
+	if (kstream_write_from_isr(&rx_stream, &byte, 1, &woken))
+		received++;
+	else
+		dropped++;
+
+	if (woken)
+		kyield();
+}
+
+static void
+uart_signal_handler(int sig)
+{
+	(void)sig;
+
+	port_linux_raise_interrupt(uart_isr);
+}
+
+static int
+start_uart_timer(void)
+{
+	struct sigaction sa;
+	struct sigevent sev;
+	struct itimerspec its;
+	timer_t timer;
+
+	sa.sa_handler = uart_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_NODEFER | SA_RESTART;
+	if (sigaction(SIGUSR1, &sa, NULL))
+		return 1;
+
+	sev.sigev_notify = SIGEV_SIGNAL;
+	sev.sigev_signo = SIGUSR1;
+	sev.sigev_value.sival_ptr = NULL;
+	if (timer_create(CLOCK_MONOTONIC, &sev, &timer))
+		return 1;
+
+	its.it_value.tv_sec = 0;
+	its.it_value.tv_nsec = UART_PERIOD_NS;
+	its.it_interval = its.it_value;
+
+	return timer_settime(timer, 0, &its, NULL);
+}
+
+void
+reader_thread(void *args)
+{
+	uint8_t chunk[32];
+	unsigned long bytes, wakeups, errors;
+	size_t i, n;
+
+	(void)args;
+
+	bytes = wakeups = errors = 0;
+	while (1) {
+		n = kstream_read(&rx_stream, chunk, sizeof(chunk), 100);
+		if (n == 0)
+			break;
+
+		wakeups++;
+		for (i = 0; i < n; i++) {
+			if (chunk[i] != (uint8_t)bytes)
+				errors++;
+			bytes++;
+		}
+	}
+
+	printf("%lu bytes in %lu wakeups (%.1f bytes per wakeup), "
+	       "%lu out of order, %lu dropped\n", bytes, wakeups,
+	       (double)bytes / wakeups, errors, dropped);
+	exit(0);
+}
+
+void
+spinning_thread(void *args)
+{
+	(void)args;
+
+	while (1)
+		;
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[2];
+	static uint8_t rx_buffer[64];
+	static uint8_t reader_thread_stack[16384];
+	static uint8_t spinning_thread_stack[16384];
+
+	if (kprovide_threads_array(threads, 2))
+		printf("threads array problem\n");
+
+	if (kstream_create(&rx_stream, rx_buffer, sizeof(rx_buffer),
+			   TRIGGER_LEVEL))
+		printf("stream problem\n");
+
+	if (kthread_create_static(reader_thread, NULL, reader_thread_stack,
+				  sizeof(reader_thread_stack), 2) <= 0)
+		printf("reader_thread problem\n");
+	if (kthread_create_static(spinning_thread, NULL, spinning_thread_stack,
+				  sizeof(spinning_thread_stack), 1) <= 0)
+		printf("spinning_thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+	if (start_uart_timer())
+		printf("uart timer problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
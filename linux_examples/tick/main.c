@@ -0,0 +1,95 @@
+/*
+ * A low priority thread spins without ever yielding, a high priority thread
+ * wakes up every 50 ticks anyway because the tick preempts the spinning one.
+ * After a second the low priority thread goes to sleep too and the system is
+ * idle; built with -DSTATIC_RTOS_TICKLESS_IDLE the tick interrupts stop while
+ * idle, which shows in the interrupt count printed at the end
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <static_rtos/kernel/scheduler.h>
+
+#define PERIOD_TICKS 50
+#define WAKEUPS 40
+
+void periodic_thread(void *args);
+void spinning_thread(void *args);
+
+static volatile unsigned long spins;
+
+void
+periodic_thread(void *args)
+{
+	struct timespec start, now;
+	unsigned long interrupts;
+	long ms;
+	int i;
+
+	(void)args;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 1; i <= WAKEUPS; i++) {
+		if (ksleep_for_ticks(PERIOD_TICKS))
+			printf("sleep problem\n");
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		ms = (now.tv_sec - start.tv_sec) * 1000 +
+		     (now.tv_nsec - start.tv_nsec) / 1000000;
+
+		PORT_BEGIN_ATOMIC();
+		printf("wakeup %d at %ld ms, spins %lu\n", i, ms, spins);
+		PORT_END_ATOMIC();
+	}
+
+	interrupts = port_linux_tick_interrupts;
+	printf("%ld ms, %lu tick interrupts\n", ms, interrupts);
+	exit(0);
+}
+
+void
+spinning_thread(void *args)
+{
+	struct timespec start, now;
+
+	(void)args;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		spins++;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000000000L +
+		 (now.tv_nsec - start.tv_nsec) < 1000000000L);
+
+	while (1)
+		ksleep_for_ticks(UINT16_MAX);
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[2];
+	static uint8_t periodic_thread_stack[16384];
+	static uint8_t spinning_thread_stack[16384];
+
+	if (kprovide_threads_array(threads, 2))
+		printf("threads array problem\n");
+
+	if (kthread_create_static(periodic_thread, NULL, periodic_thread_stack,
+				  sizeof(periodic_thread_stack), 2) <= 0)
+		printf("periodic_thread problem\n");
+	if (kthread_create_static(spinning_thread, NULL, spinning_thread_stack,
+				  sizeof(spinning_thread_stack), 1) <= 0)
+		printf("spinning_thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Traces a sensor thread that sends readings through a queue to a logger
+ * thread, both sharing a mutex with a low priority thread that holds it for a
+ * while, and writes the trace to trace.bin after 100 ticks. Convert it with
+ *
+ * ../../tools/trace_decode/trace_decode trace.bin > trace.json
+ *
+ * and open trace.json in chrome://tracing or ui.perfetto.dev
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/mutex.h>
+#include <static_rtos/kernel/queue.h>
+#include <static_rtos/kernel/trace.h>
+
+#define TRACE_RECORDS 4096
+#define TRACE_TICKS 100
+
+void sensor_thread(void *args);
+void logger_thread(void *args);
+void background_thread(void *args);
+static void write_trace(const char *path);
+
+static struct ktrace_record_t trace_buffer[TRACE_RECORDS];
+static struct kqueue_t readings;
+static uint16_t readings_buffer[8];
+static struct kmutex_t bus_mutex;
+
+static void
+write_trace(const char *path)
+{
+	struct ktrace_header_t header;
+	FILE *file;
+
+	ktrace_stop();
+	ktrace_get_header(&header);
+
+	file = fopen(path, "wb");
+	if (!file || fwrite(&header, sizeof(header), 1, file) != 1 ||
+	    fwrite(trace_buffer, sizeof(trace_buffer), 1, file) != 1) {
+		printf("write problem\n");
+		exit(1);
+	}
+	fclose(file);
+
+	printf("%lu records written to %s\n",
+	       (unsigned long)(header.written < TRACE_RECORDS ?
+			       header.written : TRACE_RECORDS), path);
+}
+
+void
+sensor_thread(void *args)
+{
+	uint16_t reading;
+
+	(void)args;
+
+	reading = 0;
+	while (1) {
+		kmutex_take(&bus_mutex, KWAIT_FOREVER);
+		reading++;
+		kmutex_give(&bus_mutex);
+
+		ktrace_user(reading);
+		kqueue_send(&readings, &reading, KWAIT_FOREVER);
+		ksleep_for_ticks(2);
+
+		if (kget_tickcount() >= TRACE_TICKS) {
+			write_trace("trace.bin");
+			exit(0);
+		}
+	}
+}
+
+void
+logger_thread(void *args)
+{
+	uint16_t reading;
+
+	(void)args;
+
+	while (1) {
+		kqueue_receive(&readings, &reading, KWAIT_FOREVER);
+		kmutex_take(&bus_mutex, KWAIT_FOREVER);
+		kmutex_give(&bus_mutex);
+	}
+}
+
+void
+background_thread(void *args)
+{
+	volatile unsigned long i;
+
+	(void)args;
+
+	/* holds the bus for a while, so the others inherit */
+	while (1) {
+		kmutex_take(&bus_mutex, KWAIT_FOREVER);
+		for (i = 0; i < 200000; i++)
+			;
+		kmutex_give(&bus_mutex);
+	}
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[3];
+	static uint8_t sensor_stack[16384];
+	static uint8_t logger_stack[16384];
+	static uint8_t background_stack[16384];
+
+	if (ktrace_start(trace_buffer, TRACE_RECORDS))
+		printf("trace problem\n");
+
+	if (kprovide_threads_array(threads, 3))
+		printf("threads array problem\n");
+
+	if (kqueue_create(&readings, readings_buffer, sizeof(readings_buffer[0]),
+			  8) || kmutex_create(&bus_mutex))
+		printf("kernel object problem\n");
+
+	if (kthread_create_static(sensor_thread, NULL, sensor_stack,
+				  sizeof(sensor_stack), 3) <= 0)
+		printf("sensor thread problem\n");
+	if (kthread_create_static(logger_thread, NULL, logger_stack,
+				  sizeof(logger_stack), 2) <= 0)
+		printf("logger thread problem\n");
+	if (kthread_create_static(background_thread, NULL, background_stack,
+				  sizeof(background_stack), 1) <= 0)
+		printf("background thread problem\n");
+
+	if (kenable_tick_interrupt())
+		printf("interrupt problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Two threads of the same priority yield to each other. Built once with the
+ * glibc ucontext functions and once with -DSTATIC_RTOS_LINUX_FAST_CONTEXT to
+ * compare the cost of a context switch
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <static_rtos/kernel/scheduler.h>
+
+#define WARMUP_YIELDS 10000
+#define MEASURED_YIELDS 2000000
+
+#ifdef STATIC_RTOS_LINUX_FAST_CONTEXT
+#define IMPLEMENTATION "fast"
+#else
+#define IMPLEMENTATION "ucontext"
+#endif
+
+void ping_pong_thread(void *args);
+static uint64_t now_ns(void);
+
+static unsigned long yields;
+static uint64_t start_ns;
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void
+ping_pong_thread(void *args)
+{
+	unsigned long *own_yields;
+
+	own_yields = args;
+
+	while (1) {
+		(*own_yields)++;
+		yields++;
+		if (yields == WARMUP_YIELDS) {
+			start_ns = now_ns();
+		} else if (yields == WARMUP_YIELDS + MEASURED_YIELDS) {
+			printf("%s\t%.1f\n", IMPLEMENTATION,
+			       (double)(now_ns() - start_ns) / MEASURED_YIELDS);
+			exit(0);
+		}
+		kyield();
+	}
+}
+
+int
+main(void)
+{
+	static struct kthread_t threads[2];
+	static uint8_t ping_stack[16384];
+	static uint8_t pong_stack[16384];
+	static unsigned long ping_yields, pong_yields;
+
+	if (kprovide_threads_array(threads, 2))
+		printf("threads array problem\n");
+
+	if (kthread_create_static(ping_pong_thread, &ping_yields, ping_stack,
+				  sizeof(ping_stack), 1) <= 0)
+		printf("ping thread problem\n");
+	if (kthread_create_static(ping_pong_thread, &pong_yields, pong_stack,
+				  sizeof(pong_stack), 1) <= 0)
+		printf("pong thread problem\n");
+
+	if (kscheduler_start())
+		printf("start scheduler problem\n");
+
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Usage of the event groups
+ *
+ * A event group is a set of event bits, statically allocated by the user and
+ * initialized with `keventgroup_create`. Threads and isrs set bits, threads
+ * wait until any (or all) of the bits they ask for are set. A waiting thread
+ * is BLOCKED, so it takes no cpu time until the bits it waits for are set or
+ * its timeout passes.
+ *
+ * The amount of bits is 16 by default and can be changed to 32 with
+ * -DSTATIC_RTOS_EVENT_GROUP_BITS=32.
+ *
+ * `keventgroup_set_from_isr` doesn't switch threads, it tells the isr if it
+ * woke a thread with a higher priority than the interrupted one. The isr is
+ * wrapped in `kisr_enter()`/`kisr_exit()` and the switch happens in
+ * `kisr_exit()`.
+ */
+
+#ifndef STATIC_RTOS_EVENTGROUP_H
+#define STATIC_RTOS_EVENTGROUP_H
+
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+
+#ifndef STATIC_RTOS_EVENT_GROUP_BITS
+#define STATIC_RTOS_EVENT_GROUP_BITS 16
+#endif
+
+#if STATIC_RTOS_EVENT_GROUP_BITS == 16
+typedef uint16_t keventbits_t;
+#elif STATIC_RTOS_EVENT_GROUP_BITS == 32
+typedef uint32_t keventbits_t;
+#else
+#error "STATIC_RTOS_EVENT_GROUP_BITS must be 16 or 32"
+#endif
+
+/* options of keventgroup_wait, they can be or'ed */
+#define KEVENT_WAIT_ANY 0x0 /**< wait until any of the bits is set */
+#define KEVENT_WAIT_ALL 0x1 /**< wait until all of the bits are set */
+#define KEVENT_CLEAR_ON_EXIT 0x2 /**< clear the bits that were waited for when
+				  **< the wait succeeds
+				  */
+
+struct keventgroup_t {
+	keventbits_t bits;
+	struct kthread_t *waiters; /**< the threads BLOCKED on the group */
+};
+
+/**
+ * This function initializes a event group
+ *
+ * @param group The statically allocated event group
+ * @param bits The initial bits
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int keventgroup_create(struct keventgroup_t *group, keventbits_t bits);
+
+/**
+ * This function waits until the bits of the group satisfy bits
+ *
+ * @param group The event group
+ * @param bits The bits to wait for, not 0
+ * @param options KEVENT_WAIT_ANY or KEVENT_WAIT_ALL, optionally or'ed with
+ *		  KEVENT_CLEAR_ON_EXIT
+ * @param tick_timeout The maximum amount of ticks to wait for. 0 doesn't wait
+ *		       and KWAIT_FOREVER waits until the bits are set
+ * @param result If not NULL, set to the bits of the group when the wait ended
+ *		 (before they were cleared)
+ *
+ * @returns Returns 0 if the bits were set and 1 on failure (timeout or it
+ *	    would have to wait outside of a thread)
+ */
+int keventgroup_wait(struct keventgroup_t *group, keventbits_t bits,
+		     uint8_t options, kticktype_t tick_timeout,
+		     keventbits_t *result);
+
+/**
+ * This function sets bits in the group and wakes up the threads whose wait is
+ * satisfied. If one of them has a higher priority than the current thread, it
+ * runs right away
+ *
+ * @param group The event group
+ * @param bits The bits to set
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int keventgroup_set(struct keventgroup_t *group, keventbits_t bits);
+
+/**
+ * This function is the version of keventgroup_set for isrs
+ *
+ * @param group The event group
+ * @param bits The bits to set
+ * @param higher_priority_woken Set to 1 if a thread with a higher priority
+ *				than the interrupted one was woken, otherwise
+ *				left as it is. Can be NULL
+ *
+ * @returns Same as keventgroup_set
+ */
+int keventgroup_set_from_isr(struct keventgroup_t *group, keventbits_t bits,
+			     int *higher_priority_woken);
+
+/**
+ * This function clears bits in the group
+ *
+ * @param group The event group
+ * @param bits The bits to clear
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int keventgroup_clear(struct keventgroup_t *group, keventbits_t bits);
+
+/**
+ * @param group The event group
+ *
+ * @returns The bits of the group
+ */
+keventbits_t keventgroup_get(struct keventgroup_t *group);
+
+#endif /* #ifndef STATIC_RTOS_EVENTGROUP_H */
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Usage of the mailboxes
+ *
+ * A mailbox is a queue of pointers (see queue.h): only the address of a
+ * message is copied, never the message. It is meant to be used with a pool
+ * (see pool.h): the sender allocates a block, fills it and posts it, the
+ * receiver fetches it and frees it when it is done with it. Until then the
+ * block belongs to whoever has the pointer.
+ *
+ * The buffer given to `kmailbox_create` is a array of capacity pointers.
+ */
+
+#ifndef STATIC_RTOS_MAILBOX_H
+#define STATIC_RTOS_MAILBOX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <static_rtos/kernel/queue.h>
+
+struct kmailbox_t {
+	struct kqueue_t queue; /**< a queue of void * items */
+};
+
+/**
+ * This function initializes a empty mailbox
+ *
+ * @param mailbox The statically allocated mailbox
+ * @param buffer The storage for the pointers
+ * @param capacity The amount of pointers in buffer
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kmailbox_create(struct kmailbox_t *mailbox, void **buffer,
+		    size_t capacity);
+
+/**
+ * This function posts the address of a message, waiting for room if the
+ * mailbox is full. Works like kqueue_send
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kmailbox_post(struct kmailbox_t *mailbox, void *message,
+		  kticktype_t tick_timeout);
+
+/**
+ * This function fetches the oldest message, waiting for one if the mailbox is
+ * empty. Works like kqueue_receive
+ *
+ * @param message Set to the address of the message
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kmailbox_fetch(struct kmailbox_t *mailbox, void **message,
+		   kticktype_t tick_timeout);
+
+/**
+ * The version of kmailbox_post for isrs. Works like kqueue_send_from_isr
+ */
+int kmailbox_post_from_isr(struct kmailbox_t *mailbox, void *message,
+			   int *higher_priority_woken);
+
+/**
+ * The version of kmailbox_fetch for isrs. Works like kqueue_receive_from_isr
+ */
+int kmailbox_fetch_from_isr(struct kmailbox_t *mailbox, void **message,
+			    int *higher_priority_woken);
+
+#endif /* #ifndef STATIC_RTOS_MAILBOX_H */
@@ -1,10 +1,86 @@
-#ifndef MUTEX_H
-#define MUTEX_X
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
 
-void kmutex_create(void);
-void kmutex_take(uint8_t *mutex_handle, uint16_t tick_timeout);
-void kmutex_give(void);
-void kmutex_is_available(void);
+/**
+ * Usage of the mutexes
+ *
+ * Mutexes are statically allocated by the user and initialized with
+ * `kmutex_create`. Only threads can take and give a mutex (not isrs or code
+ * that runs before the scheduler starts) and a mutex must be given back by the
+ * thread that took it.
+ *
+ * Threads that wait for a mutex are BLOCKED, the highest priority one gets the
+ * mutex when it is given. While a thread waits, the thread that holds the
+ * mutex inherits its priority (and so does the holder of the mutex that one
+ * waits for, and so on), so a middle priority thread can't keep a high
+ * priority thread waiting.
+ *
+ * Taking an available mutex and giving a mutex nobody waits for is a single
+ * port_atomic_cas_int; the scheduler is only entered when a thread has to
+ * wait.
+ */
 
-#endif
+#ifndef STATIC_RTOS_MUTEX_H
+#define STATIC_RTOS_MUTEX_H
 
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+
+struct kmutex_t {
+	volatile int lock; /**< 0 when available, otherwise the id of the owner.
+			    **< Once a thread had to wait for the mutex it is
+			    **< minus the id of the owner, so that the give
+			    **< goes through the kernel
+			    */
+	struct kthread_t *waiters; /**< the threads BLOCKED on the mutex */
+	struct kmutex_t *next_held; /**< the next mutex held by the owner. Only
+				     **< mutexes with a negative lock are on
+				     **< that list
+				     */
+};
+
+/**
+ * This function initializes a mutex as available
+ *
+ * @param mutex The statically allocated mutex
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kmutex_create(struct kmutex_t *mutex);
+
+/**
+ * This function takes the mutex, waiting for it if another thread holds it
+ *
+ * @param mutex The mutex to take
+ * @param tick_timeout The maximum amount of ticks to wait for. 0 doesn't wait
+ *		       and KWAIT_FOREVER waits until the mutex is available
+ *
+ * @returns Returns 0 if the mutex was taken and 1 on failure (timeout, the
+ *	    current thread already holds the mutex or it isn't called from a
+ *	    thread)
+ */
+int kmutex_take(struct kmutex_t *mutex, kticktype_t tick_timeout);
+
+/**
+ * This function gives the mutex back. If threads wait for it, the one with the
+ * highest priority gets it. The priority the current thread inherited because
+ * of this mutex is dropped
+ *
+ * @param mutex The mutex to give
+ *
+ * @returns Returns 0 on success and 1 if the current thread doesn't hold the
+ *	    mutex
+ */
+int kmutex_give(struct kmutex_t *mutex);
+
+/**
+ * @param mutex The mutex to check
+ *
+ * @returns Returns 1 if no thread holds the mutex and 0 otherwise
+ */
+int kmutex_is_available(struct kmutex_t *mutex);
+
+#endif /* #ifndef STATIC_RTOS_MUTEX_H */
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Usage of the periodic threads
+ *
+ * A thread that has to run every period ticks keeps a statically allocated
+ * `struct kperiodic_t`, starts it with `kperiodic_start` and calls
+ * `kperiodic_wait` at the end of the work of every period:
+ *
+ *	kperiodic_start(&loop, 5);
+ *	while (1) {
+ *		control();
+ *		kperiodic_wait(&loop);
+ *	}
+ *
+ * The releases (the ticks at which a period starts) are kept on the grid of
+ * the first one with `ksleep_until`, so they don't drift by the time the work
+ * took. The deadline of a period is the next release: if the work isn't done
+ * by then the deadline is missed and `kperiodic_wait` returns right away to
+ * start the late period. The releases that passed meanwhile are skipped and
+ * counted as missed too, so a overrun doesn't turn into a burst of periods.
+ * Every period also records its release jitter: how many ticks after its
+ * release the thread got to run (because of higher priority threads).
+ *
+ * In the EDF band (see STATIC_RTOS_EDF_PRIORITY in scheduler.h) the deadline
+ * of the thread is kept at the end of its current period.
+ */
+
+#ifndef STATIC_RTOS_PERIODIC_H
+#define STATIC_RTOS_PERIODIC_H
+
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+
+struct kperiodic_t {
+	kticktype_t period;
+	kticktype_t release; /**< the tick the current period was released at */
+	uint32_t periods; /**< the periods that were started */
+	uint32_t missed; /**< the deadlines that were missed, including the
+			  **< periods that were skipped
+			  */
+	kticktype_t jitter; /**< the release jitter of the current period */
+	kticktype_t max_jitter; /**< the largest release jitter */
+};
+
+/**
+ * This function starts the first period at the current tick and clears the
+ * counters. It is called by the thread itself, before its loop
+ *
+ * @param periodic The statically allocated periodic thread state
+ * @param period The amount of ticks between two releases, not 0
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kperiodic_start(struct kperiodic_t *periodic, kticktype_t period);
+
+/**
+ * This function ends the current period: it sleeps until the next release,
+ * or, if the deadline was missed, counts it and starts the late period right
+ * away
+ *
+ * @param periodic The periodic thread state given to kperiodic_start
+ *
+ * @returns Returns 0 if the deadline was met, 1 if it was missed and -1 on
+ *	    failure (outside of a thread)
+ */
+int kperiodic_wait(struct kperiodic_t *periodic);
+
+#endif /* #ifndef STATIC_RTOS_PERIODIC_H */
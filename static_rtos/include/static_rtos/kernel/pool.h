@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Usage of the memory pools
+ *
+ * A pool hands out fixed size blocks from a array the user statically
+ * allocates and gives to `kpool_create`. Allocating and freeing are O(1): the
+ * free blocks form a list linked through their own first bytes, so a block
+ * must be at least sizeof(void *) bytes.
+ *
+ * Neither function waits, so both can be used from isrs. Together with a
+ * mailbox (see mailbox.h) a producer can fill a block in place and pass only
+ * its address to a consumer, which frees the block when done with it.
+ */
+
+#ifndef STATIC_RTOS_POOL_H
+#define STATIC_RTOS_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct kpool_t {
+	uint8_t *buffer; /**< block_count * block_size bytes given by the user */
+	size_t block_size;
+	size_t block_count;
+	size_t free_count; /**< the amount of blocks in free_list */
+	void *free_list; /**< the first free block, which holds the address of
+			  **< the next one
+			  */
+};
+
+/**
+ * This function initializes a pool with all of its blocks free
+ *
+ * @param pool The statically allocated pool
+ * @param buffer The storage for the blocks, at least block_count * block_size
+ *		 bytes
+ * @param block_size The size of a block in bytes, at least sizeof(void *)
+ * @param block_count The amount of blocks in buffer
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kpool_create(struct kpool_t *pool, void *buffer, size_t block_size,
+		 size_t block_count);
+
+/**
+ * @param pool The pool to allocate from
+ *
+ * @returns A free block or NULL if all blocks are in use
+ */
+void *kpool_alloc(struct kpool_t *pool);
+
+/**
+ * This function gives a block back to its pool
+ *
+ * @param pool The pool the block was allocated from
+ * @param block The block returned by kpool_alloc
+ *
+ * @returns Returns 0 on success and 1 if block isn't a block of pool
+ */
+int kpool_free(struct kpool_t *pool, void *block);
+
+/**
+ * @param pool The pool
+ *
+ * @returns The amount of free blocks
+ */
+size_t kpool_free_count(struct kpool_t *pool);
+
+#endif /* #ifndef STATIC_RTOS_POOL_H */
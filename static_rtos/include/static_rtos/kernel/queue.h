@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Usage of the queues
+ *
+ * A queue holds up to capacity items of item_size bytes each, copied into a
+ * buffer the user statically allocates (capacity * item_size bytes) and gives
+ * to `kqueue_create`, the same way the threads array is given to the
+ * scheduler.
+ *
+ * Threads can wait for a item to arrive or for room in the queue, with a
+ * timeout. A waiting thread is BLOCKED, and the highest priority waiter is
+ * served first: a item sent while a thread waits to receive is copied straight
+ * to that thread, and a thread waiting to send is served as soon as a item is
+ * received.
+ *
+ * Isrs use the `_from_isr` functions, which never wait. They tell the isr if it
+ * woke a thread with a higher priority than the interrupted one. The isr is
+ * wrapped in `kisr_enter()`/`kisr_exit()`, like the tick isr, and the switch
+ * happens in `kisr_exit()`.
+ */
+
+#ifndef STATIC_RTOS_QUEUE_H
+#define STATIC_RTOS_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+
+struct kqueue_t {
+	uint8_t *buffer; /**< capacity * item_size bytes given by the user */
+	size_t item_size;
+	size_t capacity; /**< the maximum amount of items in the queue */
+	size_t count; /**< the amount of items in the queue */
+	size_t head; /**< the index of the oldest item */
+	struct kthread_t *receivers; /**< threads BLOCKED until a item arrives */
+	struct kthread_t *senders; /**< threads BLOCKED until there is room */
+};
+
+/**
+ * This function initializes a empty queue
+ *
+ * @param queue The statically allocated queue
+ * @param buffer The storage for the items, at least capacity * item_size bytes
+ * @param item_size The size of a item in bytes
+ * @param capacity The maximum amount of items in the queue
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kqueue_create(struct kqueue_t *queue, void *buffer, size_t item_size,
+		  size_t capacity);
+
+/**
+ * This function copies item to the back of the queue, waiting for room if it
+ * is full
+ *
+ * @param queue The queue to send to
+ * @param item The item_size bytes to copy
+ * @param tick_timeout The maximum amount of ticks to wait for. 0 doesn't wait
+ *		       and KWAIT_FOREVER waits until there is room
+ *
+ * @returns Returns 0 if the item was sent and 1 on failure (timeout or it
+ *	    would have to wait outside of a thread)
+ */
+int kqueue_send(struct kqueue_t *queue, const void *item,
+		kticktype_t tick_timeout);
+
+/**
+ * This function copies the item at the front of the queue into item and
+ * removes it from the queue, waiting for a item if it is empty
+ *
+ * @param queue The queue to receive from
+ * @param item Where to copy the item_size bytes of the item
+ * @param tick_timeout The maximum amount of ticks to wait for. 0 doesn't wait
+ *		       and KWAIT_FOREVER waits until a item arrives
+ *
+ * @returns Returns 0 if a item was received and 1 on failure (timeout or it
+ *	    would have to wait outside of a thread)
+ */
+int kqueue_receive(struct kqueue_t *queue, void *item, kticktype_t tick_timeout);
+
+/**
+ * This function is the version of kqueue_send for isrs. It never waits
+ *
+ * @param queue The queue to send to
+ * @param item The item_size bytes to copy
+ * @param higher_priority_woken Set to 1 if a thread with a higher priority
+ *				than the interrupted one was woken, otherwise
+ *				left as it is. Can be NULL
+ *
+ * @returns Returns 0 if the item was sent and 1 if the queue is full
+ */
+int kqueue_send_from_isr(struct kqueue_t *queue, const void *item,
+			 int *higher_priority_woken);
+
+/**
+ * This function is the version of kqueue_receive for isrs. It never waits
+ *
+ * @param queue The queue to receive from
+ * @param item Where to copy the item_size bytes of the item
+ * @param higher_priority_woken Set to 1 if a thread with a higher priority
+ *				than the interrupted one was woken, otherwise
+ *				left as it is. Can be NULL
+ *
+ * @returns Returns 0 if a item was received and 1 if the queue is empty
+ */
+int kqueue_receive_from_isr(struct kqueue_t *queue, void *item,
+			    int *higher_priority_woken);
+
+/**
+ * @param queue The queue
+ *
+ * @returns The amount of items in the queue
+ */
+size_t kqueue_count(struct kqueue_t *queue);
+
+#endif /* #ifndef STATIC_RTOS_QUEUE_H */
@@ -8,9 +8,9 @@
  * 
  * In order to use the rtos, the user must follow these steps:
  * 
- * 1. Statically allocate space for the idle thread stack
- * 2. Call the function `kprovide_idle_thread_stack` in order to give the scheduler
- * the address of the idle thread stack
+ * 1. Optionally, statically allocate space for the idle thread stack
+ * 2. Optionally, call the function `kprovide_idle_thread_stack` in order to
+ * give the scheduler the address of the idle thread stack
  * 3. Statically allocate space for the array of threads
  * 4. Call the function `kprovide_threads_array` in order to give the scheduler
  * the address of the threads array.\
@@ -31,24 +31,189 @@
 
 #include <static_rtos/port/port.h>
 
+/**
+ * The number of priority levels the scheduler keeps ready lists for. It can be
+ * lowered with -DSTATIC_RTOS_PRIORITY_LEVELS=N to save memory on small targets
+ * (every level costs one pointer). Must be between 2 and 256
+ */
+#ifndef STATIC_RTOS_PRIORITY_LEVELS
+#define STATIC_RTOS_PRIORITY_LEVELS 256
+#endif
+
+/**
+ * With -DSTATIC_RTOS_EDF_PRIORITY=N, the threads of priority N are scheduled
+ * earliest deadline first: instead of taking turns, the one with the earliest
+ * deadline (see kthread_set_deadline) runs, and a thread that becomes READY
+ * with a earlier deadline than the running one preempts it. The threads of
+ * higher priorities still preempt all of the band and the ones of lower
+ * priorities run when it has no READY thread
+ */
+
+/**
+ * With -DSTATIC_RTOS_QUANTUM_TICKS=N, threads of the same priority share the
+ * cpu in turns of N ticks: when the running thread used up its quantum and
+ * another thread of its priority is READY, the tick switches to that one.
+ * Every thread starts with a quantum of N, which kthread_set_quantum changes;
+ * a quantum of 0 (the default for N = 0) means that the thread only gives its
+ * turn when it yields, waits or a thread of its priority wakes up on a tick
+ */
+
+/**
+ * The width of the tick count, sleep lengths and timeouts. 16, 32 (the
+ * default) or 64 bits, chosen with -DSTATIC_RTOS_TICK_BITS=N. At 1 kHz a 16 bit
+ * tick count wraps after 65 seconds and a 32 bit one after 49 days
+ */
+#ifndef STATIC_RTOS_TICK_BITS
+#define STATIC_RTOS_TICK_BITS 32
+#endif
+
+#if STATIC_RTOS_TICK_BITS == 16
+typedef uint16_t kticktype_t;
+typedef int16_t ksignedticktype_t;
+#define KTICK_MAX UINT16_MAX
+#elif STATIC_RTOS_TICK_BITS == 32
+typedef uint32_t kticktype_t;
+typedef int32_t ksignedticktype_t;
+#define KTICK_MAX UINT32_MAX
+#elif STATIC_RTOS_TICK_BITS == 64
+typedef uint64_t kticktype_t;
+typedef int64_t ksignedticktype_t;
+#define KTICK_MAX UINT64_MAX
+#else
+#error "STATIC_RTOS_TICK_BITS must be 16, 32 or 64"
+#endif
+
+/**
+ * The signed amount of ticks from tick count b to tick count a. It stays
+ * correct across a wrap of the tick count as long as the two are less than half
+ * of the range of kticktype_t apart, so tick counts must always be compared
+ * with it (KTICK_DIFF(a, b) < 0 means a is before b) and never directly
+ */
+#define KTICK_DIFF(a, b) ((ksignedticktype_t)((kticktype_t)(a) - \
+					      (kticktype_t)(b)))
+
+/**
+ * Timeout value for the functions that wait for a kernel object, meaning that
+ * they wait until the object becomes available
+ */
+#define KWAIT_FOREVER KTICK_MAX
+
+#ifdef STATIC_RTOS_STACK_CHECK
+/**
+ * The amount of bytes at the start of every thread stack (the lowest
+ * addresses, all of the ports grow their stacks down) that are checked each
+ * time a thread is switched away from, with -DSTATIC_RTOS_STACK_CHECK. A
+ * larger canary catches overflows that skip over a few bytes, at the cost of
+ * a longer check. Can be changed with -DSTATIC_RTOS_STACK_CANARY_SIZE=N, up to
+ * 255
+ */
+#ifndef STATIC_RTOS_STACK_CANARY_SIZE
+#define STATIC_RTOS_STACK_CANARY_SIZE 4
+#endif
+/* kstack_check counts the canary bytes with a uint8_t */
+#if STATIC_RTOS_STACK_CANARY_SIZE < 1 || STATIC_RTOS_STACK_CANARY_SIZE > 255
+#error "STATIC_RTOS_STACK_CANARY_SIZE must be between 1 and 255"
+#endif
+#endif /* #ifdef STATIC_RTOS_STACK_CHECK */
+
 enum kstatus_t {
 	SUSPENDED,
 	READY,
-	RUNNING
+	RUNNING,
+	BLOCKED
 };
 
+struct kmutex_t;
+
+#ifdef STATIC_RTOS_THREAD_STATS
+
+/**
+ * How long a thread (or the scheduler) ran, kept with
+ * -DSTATIC_RTOS_THREAD_STATS. Times are in port_timestamp counts
+ * (PORT_TIMESTAMP_HZ per second) and wrap around at 32 bits, so usage is
+ * computed from the difference between two snapshots
+ */
+struct kthread_stats_t {
+	int id; /**< 0 for the scheduler, which runs when no thread is READY */
+	enum kstatus_t status; /**< RUNNING for the one that took the snapshot */
+	uint8_t priority;
+	uint32_t run_time; /**< the time it ran for */
+	uint32_t switch_count; /**< the times it was switched to */
+	uint32_t since_last_run; /**< the time since it stopped running */
+};
+
+/**
+ * What the scheduler updates on every switch
+ */
+struct krun_time_t {
+	uint32_t run_time;
+	uint32_t switch_count;
+	uint32_t last_run; /**< the timestamp when it stopped running */
+};
+
+#endif /* #ifdef STATIC_RTOS_THREAD_STATS */
+
 struct kthread_t {
 	mcu_context_t context;
 	size_t stack_size;
 	void (*func)(void *);
 	void *args;
 	void *stack;
+	struct kthread_t *ready_next; /**< next thread in the circular ready list
+				       **< of the same priority
+				       */
+	struct kthread_t *ready_prev; /**< previous thread in the circular ready
+				       **< list of the same priority
+				       */
+	struct kthread_t *sleep_next; /**< next thread in the sleep list */
+	struct kthread_t *sleep_prev; /**< previous thread in the sleep list */
+	struct kthread_t **wait_list; /**< the wait list of the kernel object the
+				       **< thread is BLOCKED on, or NULL
+				       */
+	struct kthread_t *wait_next; /**< next thread in wait_list */
+	struct kthread_t *wait_prev; /**< previous thread in wait_list */
+	void *wait_data; /**< where a kernel object copies to or from while the
+			  **< thread is BLOCKED on it
+			  */
+	struct kthread_t *notify_waiter; /**< the wait list of the thread while
+					  **< it waits for a notification
+					  */
+	struct kmutex_t *waiting_mutex; /**< the mutex the thread is BLOCKED on */
+	struct kmutex_t *held_mutexes; /**< the mutexes the thread holds */
 	enum kstatus_t status;
 	int id;
-	uint16_t wake_up_at;
-	uint8_t priority;
-	uint8_t last_run;
+	int wait_result; /**< how the last wait ended */
+	kticktype_t sleep_delta; /**< ticks left after sleep_prev wakes up */
+	uint16_t notify_count; /**< notifications not taken yet */
+	uint8_t priority; /**< the priority used for scheduling. Higher than
+			   **< base_priority while a higher priority thread
+			   **< waits for a mutex this thread holds
+			   */
+	uint8_t base_priority; /**< the priority given at creation */
 	uint8_t wake_scheduled;
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+	kticktype_t quantum; /**< the ticks of a turn, 0 for no limit */
+	kticktype_t quantum_left; /**< what is left of the current turn */
+#endif
+#ifdef STATIC_RTOS_THREAD_BUDGET
+	kticktype_t budget; /**< the ticks it may run for every budget_period,
+			     **< 0 for no limit
+			     */
+	kticktype_t budget_period;
+	kticktype_t budget_left; /**< what is left of budget in this period */
+	kticktype_t budget_period_end; /**< the tick the budget is refilled at */
+	struct kthread_t *throttled_next; /**< next thread in the throttled list */
+	uint8_t throttle_priority; /**< the base priority while throttled */
+	uint8_t throttled; /**< set while the budget is used up */
+#endif
+#ifdef STATIC_RTOS_EDF_PRIORITY
+	kticktype_t deadline; /**< the tick the work of the thread has to be done
+			       **< by, used in the EDF band
+			       */
+#endif
+#ifdef STATIC_RTOS_THREAD_STATS
+	struct krun_time_t run; /**< updated when it is switched to or away */
+#endif
 };
 
 /**
@@ -64,7 +229,10 @@ struct kthread_t {
 int kprovide_threads_array(struct kthread_t *arr, size_t arr_size);
 
 /**
- * With this function, the user will provide the stack for the idle thread
+ * With this function, the user will provide the stack for the idle thread,
+ * which runs (with the id 0) when no thread is READY and sleeps the cpu with
+ * port_idle. Without it, the idle thread runs on the stack kscheduler_start was
+ * called from. Must be called before starting the scheduler
  *
  * @param stack The allocated stack
  * @param stack_size The size of the allocated stack
@@ -73,16 +241,31 @@ int kprovide_threads_array(struct kthread_t *arr, size_t arr_size);
  */
 int kprovide_idle_thread_stack(void *stack, size_t stack_size);
 
+/**
+ * This function sets the function the idle thread calls every time before it
+ * puts the cpu to sleep, to do background work while no thread is READY. It
+ * runs on the idle thread stack, with interrupts enabled, and must not block
+ * or sleep. A thread that becomes READY meanwhile runs when the hook returns,
+ * or right away if an isr readied it
+ *
+ * @param hook The function, or NULL for none
+ */
+void kset_idle_hook(void (*hook)(void));
+
 /**
  * Function used to put a thread on the threads array. Must be called before
  * starting the scheduler
  *
- * @param func The function at which the thread will start
+ * @param func The function at which the thread will start. If it returns,
+ *	       the thread is suspended for good
  * @param args The argument passed to fun
  * @param stack The stack of the thread. Must be statically allocated by the
  *		user
- * @param stack_size The size allocated for stack
- * @param priority The desired priority of the thread, must be bigger than 0.
+ * @param stack_size The size allocated for stack. With
+ *		     -DSTATIC_RTOS_STACK_CHECK it must be bigger than
+ *		     STATIC_RTOS_STACK_CANARY_SIZE
+ * @param priority The desired priority of the thread, must be bigger than 0
+ *		   and smaller than STATIC_RTOS_PRIORITY_LEVELS and UINT8_MAX.
  *		   Higher number, higher priority.
  *
  * @return On success, it will return the id of the thread, which is a strictly
@@ -98,23 +281,68 @@ int kthread_create_static(void (*func)(void *), void *args, void *stack,
  * @param id The id of the thread to suspend. If id == 0, then suspend the
  *	     current thread
  *
- * @returns Returns 0 on success and 1 on failure.
+ * @returns Returns 0 on success and 1 on failure (also if the thread is
+ *	    BLOCKED on a kernel object).
  */
 int kthread_suspend(int id);
 
 /**
- * This function is used to unsuspend the thread indicated by id
+ * This function is used to unsuspend the thread indicated by id. Called from
+ * a isr wrapped in kisr_enter and kisr_exit, the switch to a thread that
+ * preempts the interrupted one happens in kisr_exit
  *
  * @param id The id of the thread to unsuspend. If id == 0, then unsuspend the
  *	     current thread
  *
- * @returns Returns 0 on success and 1 on failure.
+ * @returns Returns 0 on success and 1 on failure (also if the thread is
+ *	    BLOCKED on a kernel object).
  */
 int kthread_unsuspend(int id);
 
+/**
+ * This function notifies the thread indicated by id: its notification count is
+ * increased and, if it waits in kthread_notify_take, it is woken up. A
+ * notification sent before the thread waits isn't lost, it is counted
+ *
+ * @param id The id of the thread to notify
+ *
+ * @returns Returns 0 on success and 1 on failure (invalid id or the count is
+ *	    at UINT16_MAX)
+ */
+int kthread_notify(int id);
+
+/**
+ * This function is the version of kthread_notify for isrs. It doesn't switch
+ * threads; if it woke a thread with a higher priority than the interrupted
+ * one, the switch happens in kisr_exit, so the isr is wrapped in kisr_enter
+ * and kisr_exit
+ *
+ * @param id The id of the thread to notify
+ * @param higher_priority_woken Set to 1 if a thread with a higher priority
+ *				than the interrupted one was woken, otherwise
+ *				left as it is. Can be NULL
+ *
+ * @returns Same as kthread_notify
+ */
+int kthread_notify_from_isr(int id, int *higher_priority_woken);
+
+/**
+ * This function takes the notifications of the current thread, waiting for
+ * one if there are none
+ *
+ * @param clear_count If 1 all of the pending notifications are taken, else
+ *		      only one is (like a counting semaphore)
+ * @param tick_timeout The maximum amount of ticks to wait for. 0 doesn't wait
+ *		       and KWAIT_FOREVER waits until a notification comes
+ *
+ * @returns The notification count before it was taken, 0 on timeout
+ */
+uint16_t kthread_notify_take(int clear_count, kticktype_t tick_timeout);
+
 /**
  * This function is used to start the scheduler. Before starting scheduling
- * this function creates the context for every thread
+ * this function creates the context for every thread. The code that called it
+ * becomes the idle thread, moved to the idle thread stack if one was provided
  *
  * @returns On success this function doesn't return, but on failure, it will
  *	    return 1
@@ -129,7 +357,18 @@ int kscheduler_start(void);
 int kscheduler_has_started(void);
 
 /**
- * This function is used to yield execution back to the scheduler
+ * Function used by the ports to check, with interrupts disabled, if a thread
+ * is READY, e.g. before putting the cpu to sleep
+ *
+ * @returns 1 if a thread is READY and 0 otherwise
+ */
+int kscheduler_has_ready_thread(void);
+
+/**
+ * This function is used to yield execution to the next READY thread. Threads
+ * of the same priority take turns. The switch is done directly from the
+ * current thread to the next one; the scheduler context is only entered when
+ * no thread is READY
  *
  * @returns Returns 0 on success and 1 on failure.
  */
@@ -153,16 +392,162 @@ int kenable_tick_interrupt(void);
  *
  * @returns Returns 0 on success and 1 otherwise
  */
-int ksleep_for_ticks(uint16_t ticks_count);
+int ksleep_for_ticks(kticktype_t ticks_count);
 
 /**
- * This function is used to increase the tick count. If the tick count increase
- * reached a wake-up value, then it readies the specific threads
+ * This function suspends the current thread until the tick count reaches
+ * *last_wake + period and then stores that tick count in *last_wake. Unlike
+ * ksleep_for_ticks in a loop, the time the thread spends running between the
+ * calls doesn't add up, so a loop that calls it wakes up exactly every period
+ * ticks. If the wake-up time already passed, it returns right away. The
+ * periodic threads of periodic.h measure the misses and the jitter on top of it.
+ * In the EDF band, the deadline of the thread becomes its next wake-up after
+ * this one
+ *
+ * @param last_wake The tick count of the previous wake-up. Initialize it with
+ *		    kget_tickcount() before the first call
+ * @param period The amount of ticks between two wake-ups
  *
- * @returns Returns 1 if a new thread is readied and 0 otherwise
+ * @returns Returns 0 on success and 1 otherwise
+ */
+int ksleep_until(kticktype_t *last_wake, kticktype_t period);
+
+/**
+ * @returns The amount of ticks since the tick interrupt was enabled, which
+ *	    wraps around at KTICK_MAX. Compare tick counts with KTICK_DIFF
+ */
+kticktype_t kget_tickcount(void);
+
+/**
+ * This function is used to increase the tick count from the tick isr. It
+ * readies the threads whose sleep or timeout ended. If one of them has a
+ * higher or equal (so that threads of the same priority take turns) priority
+ * than the current thread, a switch becomes pending and kisr_exit does it
+ *
+ * @returns Returns 1 if a switch is pending and 0 otherwise
  */
 int kincrease_tickcount(void);
 
+/**
+ * Isrs that use the kernel call this function first. Calls can nest
+ */
+void kisr_enter(void);
+
+/**
+ * Isrs that use the kernel call this function last. When the outermost isr
+ * exits and a thread with a higher priority than the interrupted one became
+ * READY (from the tick or from the `_from_isr` functions), the switch to it is
+ * done by port_request_switch, once, instead of by every isr
+ */
+void kisr_exit(void);
+
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+
+/**
+ * This function sets the length of the turns of a thread among the threads of
+ * its priority. It applies from the next time the thread is switched to
+ *
+ * @param id The id of the thread. If id == 0, then the current thread
+ * @param ticks_count The ticks of a turn, 0 for no limit
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kthread_set_quantum(int id, kticktype_t ticks_count);
+
+#endif /* #ifdef STATIC_RTOS_QUANTUM_TICKS */
+
+#ifdef STATIC_RTOS_THREAD_BUDGET
+
+/**
+ * This function limits how long a thread runs at its priority, with
+ * -DSTATIC_RTOS_THREAD_BUDGET. Every tick that comes while the thread runs is
+ * charged to its budget; once budget ticks were charged in a period, the
+ * thread is throttled: it drops to throttle_priority (it still runs when
+ * nothing else wants the cpu, but it can't starve the threads in between)
+ * until the period ends and the budget is refilled. The periods follow each
+ * other from the call on. Priorities inherited from mutexes still apply to a
+ * throttled thread
+ *
+ * @param id The id of the thread. If id == 0, then the current thread
+ * @param budget The amount of ticks per period, 0 to remove the limit
+ * @param period The length of a period in ticks, at least budget
+ * @param throttle_priority The priority while throttled, lower than the one
+ *			    the thread was created with and bigger than 0
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kthread_set_budget(int id, kticktype_t budget, kticktype_t period,
+		       uint8_t throttle_priority);
+
+#endif /* #ifdef STATIC_RTOS_THREAD_BUDGET */
+
+#ifdef STATIC_RTOS_EDF_PRIORITY
+
+/**
+ * This function sets the absolute deadline of a thread, which orders the
+ * threads of the EDF band (priority STATIC_RTOS_EDF_PRIORITY). Deadlines are
+ * compared with KTICK_DIFF, so they must be less than half of the range of
+ * kticktype_t away. Threads start with the deadline 0; ksleep_until and the
+ * periodic threads set it to the next wake-up, which is their period later
+ *
+ * @param id The id of the thread. If id == 0, then the current thread
+ * @param deadline The tick count by which the thread has to be done
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kthread_set_deadline(int id, kticktype_t deadline);
+
+#endif /* #ifdef STATIC_RTOS_EDF_PRIORITY */
+
+#ifdef STATIC_RTOS_THREAD_STATS
+
+/**
+ * This function takes a snapshot of the run time statistics of the scheduler
+ * (the first entry) and of the threads, all at the same time. The thread that
+ * calls it is counted as running until now
+ *
+ * @param stats The array to fill, in the order of the ids
+ * @param capacity The amount of entries in stats
+ * @param total_time Set to the time since the scheduler started, to compute
+ *		     the share of each thread. Can be NULL
+ *
+ * @returns The amount of entries filled
+ */
+size_t kthread_get_stats(struct kthread_stats_t *stats, size_t capacity,
+			 uint32_t *total_time);
+
+#endif /* #ifdef STATIC_RTOS_THREAD_STATS */
+
+#ifdef STATIC_RTOS_STACK_CHECK
+
+/**
+ * This function measures how much of the stack of a thread was used so far.
+ * With -DSTATIC_RTOS_STACK_CHECK the stacks are painted with a known byte when
+ * the scheduler starts, and the bytes that were never overwritten are counted,
+ * so the result is the deepest the thread ever went. Stacks can be shrunk to
+ * it plus a margin (the isrs that interrupt the thread also use its stack)
+ *
+ * @param id The id of the thread. If id == 0, then the current thread
+ *
+ * @returns The amount of bytes used at most, 0 for a invalid id or before the
+ *	    scheduler started
+ */
+size_t kthread_stack_high_water(int id);
+
+/**
+ * This function sets the function called when a thread that is switched away
+ * from broke the canary at the end of its stack. It is called with
+ * interrupts disabled, from inside of the switch, with the id of the thread;
+ * if it returns, the switch goes on. The memory below the stack might be
+ * corrupt, so it should log and reset. Without a hook, the cpu is halted with
+ * interrupts disabled
+ *
+ * @param hook The function, or NULL to halt
+ */
+void kset_stack_overflow_hook(void (*hook)(int id));
+
+#endif /* #ifdef STATIC_RTOS_STACK_CHECK */
+
 /* TODO */
 int KARE_INTERRUPTS_ENABLED(void);
 int KBEGIN_ATOMIC(void);
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Usage of the semaphores
+ *
+ * A counting semaphore is statically allocated by the user and initialized
+ * with `ksemaphore_create`. Taking it decreases the count, waiting while it is
+ * 0; giving it increases the count, or hands the count straight to the highest
+ * priority waiting thread. Gives are counted, so none is lost if no thread was
+ * waiting yet.
+ *
+ * Isrs give with `ksemaphore_give_from_isr`. It doesn't switch threads, it
+ * tells the isr if it woke a thread with a higher priority than the
+ * interrupted one. The isr is wrapped in `kisr_enter()`/`kisr_exit()`, like
+ * the tick isr, and the switch happens in `kisr_exit()`.
+ *
+ * To wake one specific thread from a isr, the notifications of the thread (see
+ * `kthread_notify_from_isr` in scheduler.h) are lighter: they need no object.
+ */
+
+#ifndef STATIC_RTOS_SEMAPHORE_H
+#define STATIC_RTOS_SEMAPHORE_H
+
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+
+struct ksemaphore_t {
+	uint16_t count;
+	uint16_t max_count; /**< gives fail once count is max_count */
+	struct kthread_t *waiters; /**< the threads BLOCKED on the semaphore */
+};
+
+/**
+ * This function initializes a semaphore
+ *
+ * @param semaphore The statically allocated semaphore
+ * @param count The initial count
+ * @param max_count The maximum count, 1 for a binary semaphore
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int ksemaphore_create(struct ksemaphore_t *semaphore, uint16_t count,
+		      uint16_t max_count);
+
+/**
+ * This function takes the semaphore, waiting while its count is 0
+ *
+ * @param semaphore The semaphore to take
+ * @param tick_timeout The maximum amount of ticks to wait for. 0 doesn't wait
+ *		       and KWAIT_FOREVER waits until it is given
+ *
+ * @returns Returns 0 if the semaphore was taken and 1 on failure (timeout or
+ *	    it would have to wait outside of a thread)
+ */
+int ksemaphore_take(struct ksemaphore_t *semaphore, kticktype_t tick_timeout);
+
+/**
+ * This function gives the semaphore. If a thread with a higher priority than
+ * the current one was waiting, it runs right away
+ *
+ * @param semaphore The semaphore to give
+ *
+ * @returns Returns 0 on success and 1 if the count is already max_count
+ */
+int ksemaphore_give(struct ksemaphore_t *semaphore);
+
+/**
+ * This function is the version of ksemaphore_give for isrs
+ *
+ * @param semaphore The semaphore to give
+ * @param higher_priority_woken Set to 1 if a thread with a higher priority
+ *				than the interrupted one was woken, otherwise
+ *				left as it is. Can be NULL
+ *
+ * @returns Same as ksemaphore_give
+ */
+int ksemaphore_give_from_isr(struct ksemaphore_t *semaphore,
+			     int *higher_priority_woken);
+
+/**
+ * @param semaphore The semaphore
+ *
+ * @returns The count of the semaphore
+ */
+uint16_t ksemaphore_count(struct ksemaphore_t *semaphore);
+
+#endif /* #ifndef STATIC_RTOS_SEMAPHORE_H */
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Usage of the streams
+ *
+ * A stream is a ring buffer of bytes with one writer and one reader, for
+ * example a uart isr and the thread that parses what it receives. The buffer
+ * is statically allocated by the user, its size must be a power of two and at
+ * most half of the range of port_atomic_index_t (128 bytes on AVR).
+ *
+ * The writer only updates the write index and the reader only updates the
+ * read index. Both are port_atomic_index_t, which the cpu loads and stores in
+ * one instruction, so moving data doesn't disable interrupts. Only the wakeup
+ * of the reader goes through the kernel.
+ *
+ * A reader that waits in `kstream_read` is woken once trigger_level bytes
+ * (or the amount it asked for, if that is less) are available, not for every
+ * byte. Writing never waits: whatever doesn't fit is dropped and the amount
+ * written is returned.
+ *
+ * Isrs write with `kstream_write_from_isr`, which tells the isr if it woke the
+ * reader and the reader has a higher priority than the interrupted thread. The
+ * isr is wrapped in `kisr_enter()`/`kisr_exit()` and the switch happens in
+ * `kisr_exit()`.
+ */
+
+#ifndef STATIC_RTOS_STREAM_H
+#define STATIC_RTOS_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+struct kstream_t {
+	volatile uint8_t *buffer; /**< size bytes given by the user. volatile
+				   **< so the bytes are stored before the index
+				   **< that publishes them
+				   */
+	port_atomic_index_t mask; /**< size - 1 */
+	volatile port_atomic_index_t write_index; /**< only changed by the
+						   **< writer, counts up and
+						   **< wraps around
+						   */
+	volatile port_atomic_index_t read_index; /**< only changed by the
+						  **< reader
+						  */
+	port_atomic_index_t trigger_level;
+	port_atomic_index_t wanted; /**< the bytes the waiting reader needs */
+	struct kthread_t *volatile reader; /**< the reader while it is BLOCKED */
+};
+
+/**
+ * This function initializes a empty stream
+ *
+ * @param stream The statically allocated stream
+ * @param buffer The storage for the bytes
+ * @param size The size of buffer, a power of two
+ * @param trigger_level The amount of bytes that wakes up a waiting reader,
+ *			between 1 and size
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int kstream_create(struct kstream_t *stream, void *buffer, size_t size,
+		   size_t trigger_level);
+
+/**
+ * This function writes up to size bytes without waiting. If the reader waits
+ * and enough bytes are available, it is woken and runs right away if it has a
+ * higher priority than the current thread
+ *
+ * @param stream The stream to write to
+ * @param data The bytes to write
+ * @param size The amount of bytes to write
+ *
+ * @returns The amount of bytes written, less than size if the stream is full
+ */
+size_t kstream_write(struct kstream_t *stream, const void *data, size_t size);
+
+/**
+ * This function is the version of kstream_write for isrs
+ *
+ * @param stream The stream to write to
+ * @param data The bytes to write
+ * @param size The amount of bytes to write
+ * @param higher_priority_woken Set to 1 if the reader was woken and has a
+ *				higher priority than the interrupted thread,
+ *				otherwise left as it is. Can be NULL
+ *
+ * @returns Same as kstream_write
+ */
+size_t kstream_write_from_isr(struct kstream_t *stream, const void *data,
+			      size_t size, int *higher_priority_woken);
+
+/**
+ * This function reads up to size bytes. If less than trigger_level bytes (or
+ * size bytes, if that is less) are available, it waits until they are
+ *
+ * @param stream The stream to read from
+ * @param data Where to copy the bytes
+ * @param size The maximum amount of bytes to read
+ * @param tick_timeout The maximum amount of ticks to wait for. 0 doesn't wait
+ *		       and KWAIT_FOREVER waits until enough bytes arrive
+ *
+ * @returns The amount of bytes read, which can be less than the trigger level
+ *	    after a timeout
+ */
+size_t kstream_read(struct kstream_t *stream, void *data, size_t size,
+		    kticktype_t tick_timeout);
+
+/**
+ * @param stream The stream
+ *
+ * @returns The amount of bytes that can be read
+ */
+size_t kstream_available(struct kstream_t *stream);
+
+#endif /* #ifndef STATIC_RTOS_STREAM_H */
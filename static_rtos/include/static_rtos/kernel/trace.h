@@ -0,0 +1,135 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Usage of the trace
+ *
+ * Compiled with -DSTATIC_RTOS_TRACE, the kernel records what it does (thread
+ * switches, threads becoming READY, sleeping, waiting, ticks, isrs, ...) into
+ * a ring buffer of fixed size records that the user statically allocates and
+ * gives to `ktrace_start`. When the buffer is full the oldest records are
+ * overwritten. Without the flag, the hooks in the kernel are empty macros and
+ * cost nothing.
+ *
+ * A record is 8 bytes: a timestamp from the port (port_timestamp, that
+ * counts PORT_TIMESTAMP_HZ times per second and wraps around at 32
+ * bits), the event, the id of the thread it is about (ids above 255 are
+ * truncated) and a argument that depends on the event.
+ *
+ * To look at a trace, write the header from `ktrace_get_header` followed by
+ * the whole buffer, as it is, to a file (or a uart) and convert it with
+ * tools/trace_decode into a Chrome trace (chrome://tracing, ui.perfetto.dev).
+ */
+
+#ifndef STATIC_RTOS_TRACE_H
+#define STATIC_RTOS_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* "ktrc" in the byte order of the target, so the decoder can tell it */
+#define KTRACE_MAGIC 0x6b747263u
+
+/**
+ * The events. thread is the id of the thread the event is about (0 for the
+ * scheduler) and arg is described for every event
+ */
+enum ktrace_event_t {
+	KTRACE_SWITCH,		/**< thread starts running, arg is the id of
+				 **< the thread that stops
+				 */
+	KTRACE_READY,		/**< thread becomes READY */
+	KTRACE_SUSPEND,		/**< thread is suspended (also to sleep) */
+	KTRACE_SLEEP,		/**< thread sleeps for arg ticks (at most
+				 **< UINT16_MAX)
+				 */
+	KTRACE_TICK,		/**< the tick count increases by arg */
+	KTRACE_ISR_ENTER,	/**< thread is the interrupted one, arg the
+				 **< nesting before the isr
+				 */
+	KTRACE_ISR_EXIT,	/**< arg is the nesting after the isr */
+	KTRACE_BLOCK,		/**< thread waits for a kernel object (mutex,
+				 **< queue, ...)
+				 */
+	KTRACE_WAKE,		/**< thread stops waiting, arg is the
+				 **< kwait_result_t
+				 */
+	KTRACE_PRIORITY,	/**< the priority of thread changes to arg
+				 **< (mutex priority inheritance)
+				 */
+	KTRACE_USER		/**< ktrace_user was called with arg */
+};
+
+struct ktrace_record_t {
+	uint32_t timestamp;
+	uint8_t event;
+	uint8_t thread;
+	uint16_t arg;
+};
+
+/**
+ * Goes before the buffer in a dump
+ */
+struct ktrace_header_t {
+	uint32_t magic; /**< KTRACE_MAGIC */
+	uint32_t timestamp_hz; /**< PORT_TIMESTAMP_HZ */
+	uint32_t capacity; /**< the amount of records in the buffer */
+	uint32_t written; /**< the records written since ktrace_start. The
+			   **< oldest one is at written % capacity once the
+			   **< buffer is full
+			   */
+};
+
+#ifdef STATIC_RTOS_TRACE
+
+#define KTRACE(event, thread, arg) \
+	ktrace_record((event), (thread), (arg))
+
+/* a amount of ticks as a argument, UINT16_MAX if it doesn't fit */
+#define KTRACE_TICKS(ticks) \
+	((ticks) >= UINT16_MAX ? UINT16_MAX : (uint16_t)(ticks))
+
+/**
+ * This function starts tracing into buffer, from its beginning
+ *
+ * @param buffer The statically allocated records
+ * @param capacity The amount of records in buffer, must be a power of two
+ *
+ * @returns Returns 0 on success and 1 on failure
+ */
+int ktrace_start(struct ktrace_record_t *buffer, size_t capacity);
+
+/**
+ * This function stops tracing, so that the buffer can be dumped while the
+ * kernel keeps running
+ */
+void ktrace_stop(void);
+
+/**
+ * This function fills the header to dump before the buffer
+ */
+void ktrace_get_header(struct ktrace_header_t *header);
+
+/**
+ * This function records a KTRACE_USER event for the current thread, to mark
+ * points of the application in the trace
+ *
+ * @param arg A value of the user's choice
+ */
+void ktrace_user(uint16_t arg);
+
+/**
+ * This function is used by the kernel hooks to record a event. It can be called
+ * from isrs and with interrupts disabled
+ */
+void ktrace_record(uint8_t event, int thread, uint16_t arg);
+
+#else /* #ifdef STATIC_RTOS_TRACE */
+
+#define KTRACE(event, thread, arg) ((void)0)
+
+#endif /* #ifdef STATIC_RTOS_TRACE */
+
+#endif /* #ifndef STATIC_RTOS_TRACE_H */
@@ -5,6 +5,9 @@
 #ifndef PORT_H
 #define PORT_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef STATIC_RTOS_LINUX_TARGET
 #include <static_rtos/port/ports/linux_port.h>
 #endif /* #ifdef LINUX */
@@ -17,6 +20,12 @@
 #include <static_rtos/port/ports/arm_libopencm3_port.h>
 #endif /* #ifdef LIBOPENCM3 */
 
+/**
+ * The port header must also define port_atomic_index_t: the widest unsigned
+ * integer type that the cpu loads and stores in one instruction, so that a isr
+ * never sees half of a update. The streams use it for their indexes
+ */
+
 /**
  * The following functions need to be defined by the porter
  */
@@ -51,8 +60,7 @@ int port_swapcontext(mcu_context_t *oucp, const mcu_context_t *ucp);
 /**
  * This function is used to set the context of cp to point to func with
  * argument args. The stack of this context will be stack with size stack_size.
- * successor_ctx is the return context. On linux, the args argument doesn't
- * work
+ * successor_ctx is the return context
  * 
  * Before calling this function, call port_getcontext to get all other registers
  * initialized
@@ -82,6 +90,74 @@ int port_makecontext(mcu_context_t *cp, void *stackp, const size_t stack_size,
  */
 int port_enable_tick_interrupt(void);
 
+/**
+ * This function is only needed when compiling with STATIC_RTOS_TICKLESS_IDLE.
+ * It is called by the scheduler, with interrupts disabled, when no thread is
+ * READY. It stops the periodic tick, programs the timer to interrupt once after
+ * ticks_count ticks, enables interrupts and sleeps until any interrupt comes.
+ * Afterwards it disables interrupts again and restarts the periodic tick so
+ * that the next tick comes at the right time. While the tick is suppressed, the
+ * tick isr must not call kincrease_tickcount
+ *
+ * @param ticks_count The maximum amount of ticks to stay idle for. Ports clamp
+ *		      it to the longest period their timer can measure
+ *
+ * @return The amount of whole ticks that passed while idle
+ */
+uint16_t port_suppress_ticks_and_sleep(uint16_t ticks_count);
+
+/**
+ * This function is called by the idle thread, with interrupts disabled, when no
+ * thread is READY. It enables interrupts and puts the cpu to sleep in a way
+ * that a interrupt coming in between can't be missed (sei right before sleep on
+ * the avr, wfi with primask set on Cortex-M, sigsuspend on linux), lets the
+ * interrupt run and returns with interrupts disabled again. It may also return
+ * right away, for example when a interrupt is already pending
+ */
+void port_idle(void);
+
+/**
+ * This function is called by kisr_exit, at the end of the outermost isr, when
+ * a switch to another thread is pending. It must get kyield() called after the
+ * isr: either by calling it directly or by pending the lowest priority
+ * exception and calling it from there (PendSV on Cortex-M)
+ */
+void port_request_switch(void);
+
+#if defined(STATIC_RTOS_TRACE) || defined(STATIC_RTOS_THREAD_STATS)
+
+/**
+ * This function is only needed when compiling with STATIC_RTOS_TRACE or
+ * STATIC_RTOS_THREAD_STATS. It starts the counter of port_timestamp
+ */
+void port_timestamp_start(void);
+
+/**
+ * This function is only needed when compiling with STATIC_RTOS_TRACE or
+ * STATIC_RTOS_THREAD_STATS. The port header defines PORT_TIMESTAMP_HZ, the
+ * rate at which it counts. It is called for every trace record and every
+ * switch, often with interrupts disabled, so it must be short
+ *
+ * @return A counter that wraps around at 32 bits
+ */
+uint32_t port_timestamp(void);
+
+#endif /* #if defined(STATIC_RTOS_TRACE) || ... */
+
+/**
+ * This function atomically compares *ptr to expected and, only if they are
+ * equal, stores desired into it. It must be safe against isrs and, on
+ * multicore targets, other cores. It is the fast path of the mutexes, so it
+ * shouldn't do more than the instructions needed for that
+ *
+ * @param ptr The variable to update
+ * @param expected The value *ptr must have
+ * @param desired The value to store into *ptr
+ *
+ * @return 1 if desired was stored and 0 otherwise
+ */
+int port_atomic_cas_int(volatile int *ptr, int expected, int desired);
+
 /**
  * This function or macro enables global interrupts
  *
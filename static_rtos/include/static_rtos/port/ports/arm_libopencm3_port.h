@@ -5,6 +5,14 @@
 
 typedef struct cm3_context_t mcu_context_t;
 
+/* the widest type the cortex-m3 loads and stores in one instruction */
+typedef uint32_t port_atomic_index_t;
+
+/* port_timestamp is the DWT cycle counter. NOTE: it's assumed the clock is
+ * set at 72Mhz, like for the tick
+ */
+#define PORT_TIMESTAMP_HZ 72000000u
+
 /* type used to avoid a compiler warning */
 union cm3_reg_t {
 	/* so far, i don't need r_int */
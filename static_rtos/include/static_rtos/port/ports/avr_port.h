@@ -412,9 +412,16 @@ work.
  * of the project for the license text
  */
 
+/* the widest type the avr loads and stores in one instruction */
+typedef uint8_t port_atomic_index_t;
+
 #define F_CPU 16000000
 #define TCNT1_1S (65535 - (F_CPU / 1024))
-#define TCNT1_1MS (65535 - (F_CPU / 10240000))
+#define TCNT1_COUNTS_PER_TICK (F_CPU / 1024 / 1000)
+#define TCNT1_1MS (65536 - TCNT1_COUNTS_PER_TICK)
+
+/* port_timestamp counts timer1 counts, including the ones of the ticks */
+#define PORT_TIMESTAMP_HZ (F_CPU / 1024)
 
 #include <avr/interrupt.h>
 
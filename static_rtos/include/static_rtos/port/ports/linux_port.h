@@ -3,6 +3,39 @@
  * See LICENSE.txt for details
  */
 #ifndef STATIC_RTOS_LINUX_PORT_H
+#define STATIC_RTOS_LINUX_PORT_H
+
+#include <stdint.h>
+
+#ifdef STATIC_RTOS_LINUX_FAST_CONTEXT
+
+#ifndef __x86_64__
+#error "STATIC_RTOS_LINUX_FAST_CONTEXT is only implemented for x86-64"
+#endif
+
+/**
+ * With -DSTATIC_RTOS_LINUX_FAST_CONTEXT the context functions are written in
+ * assembly and only save what the x86-64 System V ABI requires a function to
+ * preserve: the callee-saved registers, the stack pointer, the return address
+ * and the floating point control words. Unlike glibc's swapcontext, the
+ * signal mask isn't touched, so switching doesn't need a syscall
+ */
+struct linux_context_t {
+	uint64_t rbx;
+	uint64_t rbp;
+	uint64_t r12;
+	uint64_t r13;
+	uint64_t r14;
+	uint64_t r15;
+	uint64_t rsp;
+	uint64_t rip;
+	uint32_t mxcsr;
+	uint16_t fpucw;
+};
+
+typedef struct linux_context_t mcu_context_t;
+
+#else /* #ifdef STATIC_RTOS_LINUX_FAST_CONTEXT */
 
 #include <ucontext.h>
 
@@ -12,22 +45,36 @@ typedef ucontext_t mcu_context_t;
 #define port_setcontext setcontext
 #define port_swapcontext swapcontext
 
-static inline void port_makecontext(mcu_context_t *ucp, void *stack, size_t stack_size,
-		      mcu_context_t *successor_ctx, void (*func)(void *),
-		      void *args);
+#endif /* #ifdef STATIC_RTOS_LINUX_FAST_CONTEXT */
 
-static inline void
-port_makecontext(mcu_context_t *ucp, void *stack, size_t stack_size,
-		      mcu_context_t *successor_ctx, void (*func)(),
-		      void *args)
-{
-	(void)args;
+/* all threads and isrs run on one host thread, so a aligned int is loaded
+ * and stored in one instruction
+ */
+typedef unsigned int port_atomic_index_t;
 
-	ucp->uc_stack.ss_sp = stack;
-	ucp->uc_stack.ss_size = stack_size;
-	ucp->uc_link = successor_ctx;
-	makecontext(ucp, func, 0);
-}
+/* port_timestamp is CLOCK_MONOTONIC in ns */
+#define PORT_TIMESTAMP_HZ 1000000000u
 
-#endif /* #ifndef STATIC_RTOS_LINUX_PORT_H */
+/**
+ * The linux port simulates interrupts with signals. Disabling interrupts only
+ * sets a flag; a signal that comes while the flag is set leaves its isr
+ * pending and the isr runs when interrupts are enabled again. Signal handlers
+ * must be installed with SA_NODEFER and call this function with the isr
+ *
+ * @param isr The function that handles the interrupt. It runs with interrupts
+ *	      disabled
+ */
+void port_linux_raise_interrupt(void (*isr)(void));
+
+/**
+ * @return Returns 1 if a isr is waiting for interrupts to be enabled
+ */
+int port_linux_is_interrupt_pending(void);
 
+/**
+ * The amount of times the tick isr ran, including the ones that ended a
+ * tickless idle period
+ */
+extern volatile unsigned long port_linux_tick_interrupts;
+
+#endif /* #ifndef STATIC_RTOS_LINUX_PORT_H */
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <static_rtos/kernel/eventgroup.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+#include "internal.h"
+
+/* types */
+
+/**
+ * What a waiting thread waits for, pointed to by its wait_data
+ */
+struct keventwait_t {
+	keventbits_t bits;
+	keventbits_t result; /**< the bits of the group when the wait ended */
+	uint8_t options;
+};
+
+/* function declarations */
+
+static int keventgroup_is_satisfied(keventbits_t group_bits,
+				    keventbits_t bits, uint8_t options);
+
+/* function definitions */
+
+int
+keventgroup_create(struct keventgroup_t *group, keventbits_t bits)
+{
+	if (!group)
+		return 1;
+
+	group->bits = bits;
+	group->waiters = NULL;
+
+	return 0;
+}
+
+int
+keventgroup_wait(struct keventgroup_t *group, keventbits_t bits,
+		 uint8_t options, kticktype_t tick_timeout, keventbits_t *result)
+{
+	int ret, interrupts;
+	struct kthread_t *current;
+	struct keventwait_t wait;
+
+	if (!group || !bits)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	current = kthread_current();
+	wait.result = group->bits;
+	if (keventgroup_is_satisfied(group->bits, bits, options)) {
+		if (options & KEVENT_CLEAR_ON_EXIT)
+			group->bits &= ~bits;
+		ret = 0;
+	} else if (tick_timeout == 0 || !current) {
+		ret = 1;
+	} else {
+		/* on success keventgroup_set_from_isr fills in the result and
+		 * clears the bits
+		 */
+		wait.bits = bits;
+		wait.options = options;
+		current->wait_data = &wait;
+		ret = kthread_block(&group->waiters, tick_timeout) !=
+		      KWAIT_SUCCESS;
+		if (ret)
+			wait.result = group->bits;
+	}
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	if (result)
+		*result = wait.result;
+
+	return ret;
+}
+
+int
+keventgroup_set(struct keventgroup_t *group, keventbits_t bits)
+{
+	int ret, woken, interrupts;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	woken = 0;
+	ret = keventgroup_set_from_isr(group, bits, &woken);
+	if (woken)
+		kreschedule();
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+int
+keventgroup_set_from_isr(struct keventgroup_t *group, keventbits_t bits,
+			 int *higher_priority_woken)
+{
+	int interrupts;
+	keventbits_t clear;
+	struct kthread_t *thread, *next;
+	struct keventwait_t *wait;
+
+	if (!group)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	group->bits |= bits;
+
+	/* every waiter sees the bits as they are after the set; the bits to
+	 * clear are only cleared once all of them were checked
+	 */
+	clear = 0;
+	for (thread = group->waiters; thread; thread = next) {
+		next = thread->wait_next;
+		wait = thread->wait_data;
+		if (!keventgroup_is_satisfied(group->bits, wait->bits,
+					      wait->options))
+			continue;
+
+		wait->result = group->bits;
+		if (wait->options & KEVENT_CLEAR_ON_EXIT)
+			clear |= wait->bits;
+		kthread_wake(thread, KWAIT_SUCCESS);
+		if (higher_priority_woken && kthread_preempts_current(thread))
+			*higher_priority_woken = 1;
+	}
+	group->bits &= ~clear;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+int
+keventgroup_clear(struct keventgroup_t *group, keventbits_t bits)
+{
+	int interrupts;
+
+	if (!group)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	group->bits &= ~bits;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+keventbits_t
+keventgroup_get(struct keventgroup_t *group)
+{
+	return group ? group->bits : 0;
+}
+
+/**
+ * This is a internal function that checks if the bits of a group satisfy a
+ * wait for bits with options
+ */
+static int
+keventgroup_is_satisfied(keventbits_t group_bits, keventbits_t bits,
+			 uint8_t options)
+{
+	if (options & KEVENT_WAIT_ALL)
+		return (group_bits & bits) == bits;
+
+	return (group_bits & bits) != 0;
+}
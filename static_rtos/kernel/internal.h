@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/**
+ * Functions that the scheduler shares with the other parts of the kernel
+ * (mutexes, ...). They aren't part of the user api.
+ *
+ * A thread that waits for a kernel object is BLOCKED: it isn't on the ready
+ * lists, it is on the wait list of the object, which is sorted by priority
+ * (threads of the same priority in the order they started to wait), and, if
+ * the wait has a timeout, on the sleep list too.
+ *
+ * All of these functions must be called with interrupts disabled.
+ */
+
+#ifndef STATIC_RTOS_KERNEL_INTERNAL_H
+#define STATIC_RTOS_KERNEL_INTERNAL_H
+
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+
+/**
+ * The result of a wait, returned by kthread_block
+ */
+enum kwait_result_t {
+	KWAIT_SUCCESS,
+	KWAIT_TIMEOUT
+};
+
+/**
+ * The id of the running thread (0 for the scheduler). Only the scheduler writes
+ * it; it can be read without disabling interrupts because a thread that is
+ * preempted sees its own id again when it resumes
+ */
+extern int kcurrent_thread_id;
+
+/**
+ * @return The thread that is running or NULL if it is the scheduler (or the
+ *	   scheduler hasn't started)
+ */
+struct kthread_t *kthread_current(void);
+
+/**
+ * @return The thread with the given id or NULL if there isn't one
+ */
+struct kthread_t *kthread_from_id(int id);
+
+/**
+ * Blocks the current thread on wait_list until kthread_wake is called for it
+ * or until tick_timeout ticks pass. Returns after the thread runs again
+ *
+ * @param wait_list The wait list of the kernel object
+ * @param tick_timeout The maximum amount of ticks to wait for or KWAIT_FOREVER
+ *
+ * @returns The result given to kthread_wake or KWAIT_TIMEOUT
+ */
+int kthread_block(struct kthread_t **wait_list, kticktype_t tick_timeout);
+
+/**
+ * Takes a BLOCKED thread off its wait list (and the sleep list) and readies
+ * it. It doesn't switch to it
+ *
+ * @param thread The thread to wake up
+ * @param result The value kthread_block will return in the thread
+ */
+void kthread_wake(struct kthread_t *thread, int result);
+
+/**
+ * Changes the (effective) priority of a thread, moving it on its ready list or
+ * wait list accordingly. It doesn't switch threads
+ */
+void kthread_set_priority(struct kthread_t *thread, uint8_t priority);
+
+/**
+ * @return Returns 1 if thread has to run before the running thread (a higher
+ *	   priority or, in the EDF band, a earlier deadline) or if no thread is
+ *	   running
+ */
+int kthread_preempts_current(const struct kthread_t *thread);
+
+/**
+ * Yields if a READY thread has a higher priority than the current one
+ */
+void kreschedule(void);
+
+/**
+ * The priority a thread has when it doesn't inherit one from a mutex: the
+ * priority given at creation, or the throttle priority while the thread has
+ * used up its budget
+ */
+#ifdef STATIC_RTOS_THREAD_BUDGET
+#define KTHREAD_BASE_PRIORITY(THREAD) ((THREAD)->throttled ? \
+				       (THREAD)->throttle_priority : \
+				       (THREAD)->base_priority)
+#else
+#define KTHREAD_BASE_PRIORITY(THREAD) ((THREAD)->base_priority)
+#endif
+
+/**
+ * Recalculates the priority of thread from KTHREAD_BASE_PRIORITY and the
+ * highest priority waiter of every mutex it holds, and then the priority of
+ * the owner of the mutex it waits for, and so on. It doesn't switch threads
+ */
+void kmutex_update_priority(struct kthread_t *thread);
+
+#endif /* #ifndef STATIC_RTOS_KERNEL_INTERNAL_H */
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <static_rtos/kernel/mailbox.h>
+#include <static_rtos/kernel/queue.h>
+
+/* function definitions */
+
+int
+kmailbox_create(struct kmailbox_t *mailbox, void **buffer, size_t capacity)
+{
+	if (!mailbox)
+		return 1;
+
+	return kqueue_create(&mailbox->queue, buffer, sizeof(void *),
+			     capacity);
+}
+
+int
+kmailbox_post(struct kmailbox_t *mailbox, void *message, kticktype_t tick_timeout)
+{
+	if (!mailbox)
+		return 1;
+
+	return kqueue_send(&mailbox->queue, &message, tick_timeout);
+}
+
+int
+kmailbox_fetch(struct kmailbox_t *mailbox, void **message,
+	       kticktype_t tick_timeout)
+{
+	if (!mailbox)
+		return 1;
+
+	return kqueue_receive(&mailbox->queue, message, tick_timeout);
+}
+
+int
+kmailbox_post_from_isr(struct kmailbox_t *mailbox, void *message,
+		       int *higher_priority_woken)
+{
+	if (!mailbox)
+		return 1;
+
+	return kqueue_send_from_isr(&mailbox->queue, &message,
+				    higher_priority_woken);
+}
+
+int
+kmailbox_fetch_from_isr(struct kmailbox_t *mailbox, void **message,
+			int *higher_priority_woken)
+{
+	if (!mailbox)
+		return 1;
+
+	return kqueue_receive_from_isr(&mailbox->queue, message,
+				       higher_priority_woken);
+}
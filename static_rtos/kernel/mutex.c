@@ -0,0 +1,254 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <static_rtos/kernel/mutex.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+#include "internal.h"
+
+/* function declarations */
+
+static int kmutex_take_slow(struct kmutex_t *mutex, kticktype_t tick_timeout);
+static int kmutex_give_slow(struct kmutex_t *mutex);
+static struct kthread_t *kmutex_owner(const struct kmutex_t *mutex);
+static void kmutex_set_owner(struct kmutex_t *mutex, struct kthread_t *owner);
+static void kmutex_remove_held(struct kmutex_t *mutex, struct kthread_t *owner);
+static void kmutex_inherit_priority(struct kmutex_t *mutex, uint8_t priority);
+
+/* function definitions */
+
+int
+kmutex_create(struct kmutex_t *mutex)
+{
+	if (!mutex)
+		return 1;
+
+	mutex->lock = 0;
+	mutex->waiters = NULL;
+	mutex->next_held = NULL;
+
+	return 0;
+}
+
+int
+kmutex_take(struct kmutex_t *mutex, kticktype_t tick_timeout)
+{
+	int id;
+
+	id = kcurrent_thread_id;
+	if (!mutex || id <= 0)
+		return 1;
+
+	if (port_atomic_cas_int(&mutex->lock, 0, id))
+		return 0;
+
+	return kmutex_take_slow(mutex, tick_timeout);
+}
+
+int
+kmutex_give(struct kmutex_t *mutex)
+{
+	int id;
+
+	id = kcurrent_thread_id;
+	if (!mutex || id <= 0)
+		return 1;
+
+	if (port_atomic_cas_int(&mutex->lock, id, 0))
+		return 0;
+
+	return kmutex_give_slow(mutex);
+}
+
+int
+kmutex_is_available(struct kmutex_t *mutex)
+{
+	return mutex && mutex->lock == 0;
+}
+
+/**
+ * This is a internal function that takes the mutex when the fast path failed,
+ * blocking the current thread if another thread holds it
+ */
+static int
+kmutex_take_slow(struct kmutex_t *mutex, kticktype_t tick_timeout)
+{
+	int ret, interrupts, lock;
+	struct kthread_t *current, *owner;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	current = kthread_current();
+	lock = mutex->lock;
+	if (lock == 0) {
+		/* given back since the fast path looked at it */
+		mutex->lock = current->id;
+		ret = 0;
+	} else if (lock == current->id || lock == -current->id ||
+		   tick_timeout == 0) {
+		ret = 1;
+	} else {
+		/* from now on the owner has to give through the kernel */
+		if (lock > 0) {
+			owner = kthread_from_id(lock);
+			mutex->lock = -lock;
+			mutex->next_held = owner->held_mutexes;
+			owner->held_mutexes = mutex;
+		}
+
+		kmutex_inherit_priority(mutex, current->priority);
+
+		/* on success kmutex_give_slow already made this thread the
+		 * owner
+		 */
+		current->waiting_mutex = mutex;
+		ret = kthread_block(&mutex->waiters, tick_timeout) != KWAIT_SUCCESS;
+		current->waiting_mutex = NULL;
+
+		/* the holder may not need the priority of this thread anymore */
+		if (ret)
+			kmutex_update_priority(kmutex_owner(mutex));
+	}
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+/**
+ * This is a internal function that gives the mutex when the fast path failed,
+ * which happens when threads waited for it (or the current thread isn't the
+ * owner)
+ */
+static int
+kmutex_give_slow(struct kmutex_t *mutex)
+{
+	int interrupts;
+	struct kthread_t *current, *next;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	current = kthread_current();
+	if (mutex->lock != -current->id) {
+		if (interrupts)
+			PORT_ENABLE_INTERRUPTS();
+		return 1;
+	}
+
+	kmutex_remove_held(mutex, current);
+
+	/* hand the mutex straight to the highest priority waiter */
+	next = mutex->waiters;
+	if (next) {
+		kthread_wake(next, KWAIT_SUCCESS);
+		kmutex_set_owner(mutex, next);
+		kmutex_update_priority(next);
+	} else {
+		mutex->lock = 0;
+	}
+
+	kmutex_update_priority(current);
+	kreschedule();
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+/**
+ * This is a internal function that returns the thread that holds mutex or
+ * NULL if it is available
+ */
+static struct kthread_t *
+kmutex_owner(const struct kmutex_t *mutex)
+{
+	return kthread_from_id(mutex->lock < 0 ? -mutex->lock : mutex->lock);
+}
+
+/**
+ * This is a internal function that makes owner the owner of mutex. If other
+ * threads still wait for it, mutex is added to the list of mutexes held by
+ * owner and the give has to go through the kernel
+ */
+static void
+kmutex_set_owner(struct kmutex_t *mutex, struct kthread_t *owner)
+{
+	if (mutex->waiters) {
+		mutex->lock = -owner->id;
+		mutex->next_held = owner->held_mutexes;
+		owner->held_mutexes = mutex;
+	} else {
+		mutex->lock = owner->id;
+	}
+}
+
+/**
+ * This is a internal function that removes mutex from the list of mutexes held
+ * by owner
+ */
+static void
+kmutex_remove_held(struct kmutex_t *mutex, struct kthread_t *owner)
+{
+	struct kmutex_t **held;
+
+	for (held = &owner->held_mutexes; *held; held = &(*held)->next_held) {
+		if (*held == mutex) {
+			*held = mutex->next_held;
+			break;
+		}
+	}
+
+	mutex->next_held = NULL;
+}
+
+/**
+ * This is a internal function that raises the priority of the owner of mutex
+ * to priority. If the owner itself waits for a mutex, the owner of that mutex
+ * is raised too, and so on
+ */
+static void
+kmutex_inherit_priority(struct kmutex_t *mutex, uint8_t priority)
+{
+	struct kthread_t *owner;
+
+	while (mutex) {
+		owner = kmutex_owner(mutex);
+		if (!owner || owner->priority >= priority)
+			break;
+
+		kthread_set_priority(owner, priority);
+		mutex = owner->waiting_mutex;
+	}
+}
+
+void
+kmutex_update_priority(struct kthread_t *thread)
+{
+	struct kmutex_t *mutex;
+	uint8_t priority;
+
+	while (thread) {
+		priority = KTHREAD_BASE_PRIORITY(thread);
+		for (mutex = thread->held_mutexes; mutex;
+		     mutex = mutex->next_held) {
+			if (mutex->waiters &&
+			    mutex->waiters->priority > priority)
+				priority = mutex->waiters->priority;
+		}
+
+		if (priority == thread->priority)
+			break;
+
+		kthread_set_priority(thread, priority);
+		thread = thread->waiting_mutex ?
+			 kmutex_owner(thread->waiting_mutex) : NULL;
+	}
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <static_rtos/kernel/periodic.h>
+#include <static_rtos/kernel/scheduler.h>
+
+/* function definitions */
+
+int
+kperiodic_start(struct kperiodic_t *periodic, kticktype_t period)
+{
+	if (!periodic || !period)
+		return 1;
+
+	if (!kscheduler_has_started())
+		return 1;
+
+	periodic->period = period;
+	periodic->release = kget_tickcount();
+	periodic->periods = 1;
+	periodic->missed = 0;
+	periodic->jitter = 0;
+	periodic->max_jitter = 0;
+
+#ifdef STATIC_RTOS_EDF_PRIORITY
+	kthread_set_deadline(0, periodic->release + period);
+#endif
+
+	return 0;
+}
+
+int
+kperiodic_wait(struct kperiodic_t *periodic)
+{
+	ksignedticktype_t late;
+	kticktype_t skipped;
+	int missed;
+
+	if (!periodic)
+		return -1;
+
+	/* late >= 0: the next release (the deadline) came before the work
+	 * was done
+	 */
+	late = KTICK_DIFF(kget_tickcount(),
+			  periodic->release + periodic->period);
+	missed = 0;
+	if (late >= 0) {
+		skipped = (kticktype_t)late / periodic->period;
+		periodic->missed += skipped + 1;
+		periodic->release += skipped * periodic->period;
+		missed = 1;
+	}
+
+	/* after a miss, the late release already passed, so this only moves
+	 * to it (and the deadline in the EDF band) without sleeping
+	 */
+	if (ksleep_until(&periodic->release, periodic->period))
+		return -1;
+
+	periodic->periods++;
+	periodic->jitter = kget_tickcount() - periodic->release;
+	if (periodic->jitter > periodic->max_jitter)
+		periodic->max_jitter = periodic->jitter;
+
+	return missed;
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <string.h>
+
+#include <static_rtos/kernel/pool.h>
+#include <static_rtos/port/port.h>
+
+/* function definitions */
+
+int
+kpool_create(struct kpool_t *pool, void *buffer, size_t block_size,
+	     size_t block_count)
+{
+	size_t i;
+	void *next;
+
+	if (!pool || !buffer || block_size < sizeof(void *) || !block_count)
+		return 1;
+
+	pool->buffer = buffer;
+	pool->block_size = block_size;
+	pool->block_count = block_count;
+	pool->free_count = block_count;
+	pool->free_list = pool->buffer;
+
+	/* the links are copied because a block may not be aligned for a
+	 * pointer
+	 */
+	for (i = 0; i < block_count; i++) {
+		next = i + 1 < block_count ?
+		       pool->buffer + (i + 1) * block_size : NULL;
+		memcpy(pool->buffer + i * block_size, &next, sizeof(next));
+	}
+
+	return 0;
+}
+
+void *
+kpool_alloc(struct kpool_t *pool)
+{
+	int interrupts;
+	void *block;
+
+	if (!pool)
+		return NULL;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	block = pool->free_list;
+	if (block) {
+		memcpy(&pool->free_list, block, sizeof(pool->free_list));
+		pool->free_count--;
+	}
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return block;
+}
+
+int
+kpool_free(struct kpool_t *pool, void *block)
+{
+	int interrupts;
+	size_t offset;
+
+	if (!pool || (uint8_t *)block < pool->buffer)
+		return 1;
+
+	offset = (uint8_t *)block - pool->buffer;
+	if (offset % pool->block_size ||
+	    offset / pool->block_size >= pool->block_count)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	memcpy(block, &pool->free_list, sizeof(pool->free_list));
+	pool->free_list = block;
+	pool->free_count++;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+size_t
+kpool_free_count(struct kpool_t *pool)
+{
+	return pool ? pool->free_count : 0;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <string.h>
+
+#include <static_rtos/kernel/queue.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+#include "internal.h"
+
+/* function declarations */
+
+static struct kthread_t *kqueue_try_send(struct kqueue_t *queue,
+					 const void *item, int *ret);
+static struct kthread_t *kqueue_try_receive(struct kqueue_t *queue, void *item,
+					    int *ret);
+
+/* function definitions */
+
+int
+kqueue_create(struct kqueue_t *queue, void *buffer, size_t item_size,
+	      size_t capacity)
+{
+	if (!queue || !buffer || !item_size || !capacity)
+		return 1;
+
+	queue->buffer = buffer;
+	queue->item_size = item_size;
+	queue->capacity = capacity;
+	queue->count = 0;
+	queue->head = 0;
+	queue->receivers = NULL;
+	queue->senders = NULL;
+
+	return 0;
+}
+
+int
+kqueue_send(struct kqueue_t *queue, const void *item, kticktype_t tick_timeout)
+{
+	int ret, interrupts;
+	struct kthread_t *current, *woken;
+
+	if (!queue || !item)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	woken = kqueue_try_send(queue, item, &ret);
+	current = kthread_current();
+	if (ret && tick_timeout != 0 && current) {
+		/* the receiver that takes the place of this item copies it */
+		current->wait_data = (void *)item;
+		ret = kthread_block(&queue->senders, tick_timeout) !=
+		      KWAIT_SUCCESS;
+	}
+
+	if (woken)
+		kreschedule();
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+int
+kqueue_receive(struct kqueue_t *queue, void *item, kticktype_t tick_timeout)
+{
+	int ret, interrupts;
+	struct kthread_t *current, *woken;
+
+	if (!queue || !item)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	woken = kqueue_try_receive(queue, item, &ret);
+	current = kthread_current();
+	if (ret && tick_timeout != 0 && current) {
+		/* the sender copies the item straight to this thread */
+		current->wait_data = item;
+		ret = kthread_block(&queue->receivers, tick_timeout) !=
+		      KWAIT_SUCCESS;
+	}
+
+	if (woken)
+		kreschedule();
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+int
+kqueue_send_from_isr(struct kqueue_t *queue, const void *item,
+		     int *higher_priority_woken)
+{
+	int ret, interrupts;
+	struct kthread_t *woken;
+
+	if (!queue || !item)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	woken = kqueue_try_send(queue, item, &ret);
+	if (woken && higher_priority_woken && kthread_preempts_current(woken))
+		*higher_priority_woken = 1;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+int
+kqueue_receive_from_isr(struct kqueue_t *queue, void *item,
+			int *higher_priority_woken)
+{
+	int ret, interrupts;
+	struct kthread_t *woken;
+
+	if (!queue || !item)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	woken = kqueue_try_receive(queue, item, &ret);
+	if (woken && higher_priority_woken && kthread_preempts_current(woken))
+		*higher_priority_woken = 1;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+size_t
+kqueue_count(struct kqueue_t *queue)
+{
+	return queue ? queue->count : 0;
+}
+
+/**
+ * This is a internal function that sends item without waiting. It must be
+ * called with interrupts disabled. If a thread waits to receive, the queue is
+ * empty and item is copied straight to that thread
+ *
+ * @param ret Set to 0 if item was sent and 1 if the queue is full
+ *
+ * @returns The receiver that was woken or NULL
+ */
+static struct kthread_t *
+kqueue_try_send(struct kqueue_t *queue, const void *item, int *ret)
+{
+	struct kthread_t *receiver;
+	size_t tail;
+
+	receiver = queue->receivers;
+	if (receiver) {
+		memcpy(receiver->wait_data, item, queue->item_size);
+		kthread_wake(receiver, KWAIT_SUCCESS);
+		*ret = 0;
+		return receiver;
+	}
+
+	if (queue->count == queue->capacity) {
+		*ret = 1;
+		return NULL;
+	}
+
+	tail = queue->head + queue->count;
+	if (tail >= queue->capacity)
+		tail -= queue->capacity;
+	memcpy(queue->buffer + tail * queue->item_size, item, queue->item_size);
+	queue->count++;
+
+	*ret = 0;
+	return NULL;
+}
+
+/**
+ * This is a internal function that receives into item without waiting. It
+ * must be called with interrupts disabled. If a thread waits to send, the
+ * queue was full and the item of that thread takes the freed place
+ *
+ * @param ret Set to 0 if a item was received and 1 if the queue is empty
+ *
+ * @returns The sender that was woken or NULL
+ */
+static struct kthread_t *
+kqueue_try_receive(struct kqueue_t *queue, void *item, int *ret)
+{
+	struct kthread_t *sender;
+	uint8_t *slot;
+
+	if (queue->count == 0) {
+		*ret = 1;
+		return NULL;
+	}
+
+	slot = queue->buffer + queue->head * queue->item_size;
+	memcpy(item, slot, queue->item_size);
+	*ret = 0;
+
+	sender = queue->senders;
+	if (sender) {
+		/* the queue stays full: the oldest place becomes the newest */
+		memcpy(slot, sender->wait_data, queue->item_size);
+		kthread_wake(sender, KWAIT_SUCCESS);
+	} else {
+		queue->count--;
+	}
+
+	queue->head++;
+	if (queue->head == queue->capacity)
+		queue->head = 0;
+
+	return sender;
+}
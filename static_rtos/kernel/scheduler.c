@@ -2,35 +2,95 @@
  * Copyright 2024 Timothy Joseph. Subject to MIT license
  * See LICENSE.txt for details
  */
-/*
- * TODO:
- *
- * -> mutexes
- * -> don't swap the context to the scheduler on every tick
- */
 #include <stdio.h>
+#include <string.h>
 #include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/kernel/trace.h>
 #include <static_rtos/port/port.h>
 
+#include "internal.h"
+
 /* macros */
 
 #define K_ID_TO_INDEX(ID) ((ID) - 1)
+#define K_PRIORITY_GROUPS ((STATIC_RTOS_PRIORITY_LEVELS + 7) / 8)
+
+/* the byte unused stack is painted with */
+#define KSTACK_PAINT 0xa5
+
+#if STATIC_RTOS_PRIORITY_LEVELS < 2 || STATIC_RTOS_PRIORITY_LEVELS > 256
+#error "STATIC_RTOS_PRIORITY_LEVELS must be between 2 and 256"
+#endif
+
+#ifdef STATIC_RTOS_EDF_PRIORITY
+#if STATIC_RTOS_EDF_PRIORITY < 1 || \
+    STATIC_RTOS_EDF_PRIORITY >= STATIC_RTOS_PRIORITY_LEVELS || \
+    STATIC_RTOS_EDF_PRIORITY >= 255
+#error "STATIC_RTOS_EDF_PRIORITY must be a priority a thread can have"
+#endif
+/* the ready list of the EDF band is sorted by deadline instead of rotated */
+#define K_IS_EDF(PRIORITY) ((PRIORITY) == STATIC_RTOS_EDF_PRIORITY)
+#else
+#define K_IS_EDF(PRIORITY) 0
+#endif
+
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+#define KQUANTUM_LEFT(THREAD) ((THREAD)->quantum_left)
+#else
+#define KQUANTUM_LEFT(THREAD) 0
+#endif
 
 /* types */
 
 enum wakeup_reason_t {
 	NO_REASON,
 	SLEEP_SCHEDULED,
-	SLEEP_SCHEDULED_OVERFLOW,
-	MUTEX_SCHEDULED
+	WAIT_SCHEDULED
 };
 
 /* function declarations */
 
+static int kmake_context(struct kthread_t *thread);
+static void kthread_entry(void *args);
 static int kmake_context_for_all_threads(void);
+static void kidle_thread(void *args);
 static int get_next_id(void);
-static void make_0_last_run_for_priority(uint8_t priority);
+static int khighest_ready_priority(void);
 static int kswitch_to_thread_by_id(int id);
+static void kready_list_insert(struct kthread_t *thread);
+static void kready_list_remove(struct kthread_t *thread);
+static int kthread_runs_before(const struct kthread_t *a,
+			       const struct kthread_t *b);
+#ifdef STATIC_RTOS_EDF_PRIORITY
+static void kthread_change_deadline(struct kthread_t *thread,
+				    kticktype_t deadline);
+#endif
+static void kthread_make_ready(struct kthread_t *thread);
+static void kthread_make_suspended(struct kthread_t *thread);
+static void ksleep_list_insert(struct kthread_t *thread,
+			       kticktype_t ticks_count);
+static void ksleep_list_remove(struct kthread_t *thread);
+static int ksleep_current(kticktype_t ticks_count);
+static int kadvance_tickcount(kticktype_t ticks_count);
+static void kwait_list_insert(struct kthread_t **wait_list,
+			      struct kthread_t *thread);
+static void kwait_list_remove(struct kthread_t *thread);
+static uint8_t khighest_bit8(uint8_t x);
+static uint8_t khighest_bit32(uint32_t x);
+#ifdef STATIC_RTOS_THREAD_STATS
+static struct krun_time_t *krun_time_of(int id);
+static void krun_time_switch(int old_id, int id);
+#endif
+#ifdef STATIC_RTOS_STACK_CHECK
+static void kstack_check(struct kthread_t *thread);
+#endif
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+static int kquantum_advance(kticktype_t ticks_count);
+#endif
+#ifdef STATIC_RTOS_THREAD_BUDGET
+static int kbudget_advance(kticktype_t ticks_count);
+static void kbudget_replenish(struct kthread_t *thread);
+#endif
 
 /* global variables */
 
@@ -43,19 +103,75 @@ static size_t kthreads_arr_allocated_size; /**< The allocated size of
 static size_t kthreads_arr_used_size; /**< The amount of threads that have been
 				       **< initialized
 				       */
-static uint16_t ktickcount; /**< The tick count that is increased from the tick
-			     **< isr (TODO: ticktype_t)
-			     */
+static kticktype_t ktickcount; /**< The tick count that is increased from the
+				**< tick isr
+				*/
 static int kstarted_scheduler; /**< flag used internally to determine if the
 				**< scheduler is running
 				*/
-static int kcurrent_thread_id; /**< the id of the current running thread
-				**< 0 = the idle thread, but the idle thread
-				**< isn't in kthreads_arr, so a function is
-				**< used to translate the id to a index
+static int ktick_enabled; /**< flag set when the tick interrupt was enabled */
+static volatile uint8_t kswitch_pending; /**< set when a thread that should
+					  **< preempt the current one became
+					  **< READY; cleared by the next switch
+					  */
+static volatile uint8_t kisr_nesting; /**< the amount of nested isrs between
+				       **< kisr_enter and kisr_exit
+				       */
+int kcurrent_thread_id; /**< the id of the current running thread
+			 **< 0 = the idle thread, but the idle thread
+			 **< isn't in kthreads_arr, so a function is
+			 **< used to translate the id to a index
+			 */
+static mcu_context_t kscheduler_context; /**< the context of the idle thread
+					  **< (id 0), which runs when no
+					  **< thread is READY
+					  */
+static void *kidle_stack; /**< the stack of the idle thread, or NULL to run it
+			   **< on the stack kscheduler_start was called from
+			   */
+static size_t kidle_stack_size;
+static void (*kidle_hook)(void); /**< called by the idle thread before it
+				  **< sleeps, or NULL
+				  */
+static struct kthread_t *kready_lists[STATIC_RTOS_PRIORITY_LEVELS]; /**< the
+				**< head of the circular ready list of every
+				**< priority. The head is the next thread of
+				**< that priority that will run
+				*/
+static uint8_t kready_bitmap[K_PRIORITY_GROUPS]; /**< bit (p % 8) of byte
+				**< (p / 8) is set if kready_lists[p] isn't
+				**< empty
 				*/
-/* TODO: describe these */
-static mcu_context_t kscheduler_context;
+static uint32_t kready_group_bitmap; /**< bit g is set if kready_bitmap[g]
+				      **< isn't 0
+				      */
+static struct kthread_t *ksleep_list; /**< the sleeping threads, sorted by
+				       **< wake-up time. Every thread keeps the
+				       **< number of ticks between its wake-up
+				       **< and the one of the thread before it,
+				       **< so the tick only touches the head
+				       */
+#ifdef STATIC_RTOS_THREAD_STATS
+static struct krun_time_t kscheduler_run; /**< the run time of the scheduler
+					   **< context, which is the idle time
+					   */
+static uint32_t krun_switch_time; /**< the timestamp of the last switch */
+static uint32_t krun_start_time; /**< the timestamp when scheduling started */
+#endif
+#ifdef STATIC_RTOS_THREAD_BUDGET
+static struct kthread_t *kthrottled_list; /**< the threads that used up their
+					  **< budget, waiting for the end of
+					  **< their budget period
+					  */
+#endif
+#ifdef STATIC_RTOS_STACK_CHECK
+static void (*kstack_overflow_hook)(int id); /**< called when a canary is
+					      **< found broken, NULL to halt
+					      */
+#endif
+static const uint8_t khighest_bit_table[16] = {
+	0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3
+}; /**< index of the highest set bit of a nibble */
 
 /* function definitions */
 
@@ -84,16 +200,47 @@ kprovide_threads_array(struct kthread_t *arr, size_t arr_size)
 	return 0;
 }
 
+int
+kprovide_idle_thread_stack(void *stack, size_t stack_size)
+{
+	if (!stack || !stack_size)
+		return 1;
+
+	if (kstarted_scheduler)
+		return 1;
+
+	kidle_stack = stack;
+	kidle_stack_size = stack_size;
+
+	return 0;
+}
+
+void
+kset_idle_hook(void (*hook)(void))
+{
+	kidle_hook = hook;
+}
+
 int
 kthread_create_static(void (*func)(void *), void *args, void *stack,
 		      size_t stack_size, uint8_t priority)
 {
 	if (!func || !stack || !stack_size)
 		return -1;
+
+#ifdef STATIC_RTOS_STACK_CHECK
+	if (stack_size <= STATIC_RTOS_STACK_CANARY_SIZE)
+		return -1;
+#endif
 	
 	if (priority == 0 || priority == UINT8_MAX)
 		return -1;
 
+#if STATIC_RTOS_PRIORITY_LEVELS < 256
+	if (priority >= STATIC_RTOS_PRIORITY_LEVELS)
+		return -1;
+#endif
+
 	if (kstarted_scheduler)
 		return -1;
 
@@ -104,12 +251,40 @@ kthread_create_static(void (*func)(void *), void *args, void *stack,
 	kthreads_arr[kthreads_arr_used_size].func = func;
 	kthreads_arr[kthreads_arr_used_size].args = args;
 	kthreads_arr[kthreads_arr_used_size].stack = stack;
-	kthreads_arr[kthreads_arr_used_size].status = READY;
+	kthreads_arr[kthreads_arr_used_size].status = SUSPENDED;
 	kthreads_arr[kthreads_arr_used_size].id = kthreads_arr_used_size + 1;
-	kthreads_arr[kthreads_arr_used_size].wake_up_at = 0;
+	kthreads_arr[kthreads_arr_used_size].sleep_next = NULL;
+	kthreads_arr[kthreads_arr_used_size].sleep_prev = NULL;
+	kthreads_arr[kthreads_arr_used_size].sleep_delta = 0;
+	kthreads_arr[kthreads_arr_used_size].wait_list = NULL;
+	kthreads_arr[kthreads_arr_used_size].wait_next = NULL;
+	kthreads_arr[kthreads_arr_used_size].wait_prev = NULL;
+	kthreads_arr[kthreads_arr_used_size].wait_data = NULL;
+	kthreads_arr[kthreads_arr_used_size].notify_waiter = NULL;
+	kthreads_arr[kthreads_arr_used_size].notify_count = 0;
+	kthreads_arr[kthreads_arr_used_size].waiting_mutex = NULL;
+	kthreads_arr[kthreads_arr_used_size].held_mutexes = NULL;
+	kthreads_arr[kthreads_arr_used_size].wait_result = KWAIT_SUCCESS;
 	kthreads_arr[kthreads_arr_used_size].priority = priority;
-	kthreads_arr[kthreads_arr_used_size].last_run = 0;
+	kthreads_arr[kthreads_arr_used_size].base_priority = priority;
 	kthreads_arr[kthreads_arr_used_size].wake_scheduled = 0;
+#ifdef STATIC_RTOS_THREAD_STATS
+	kthreads_arr[kthreads_arr_used_size].run.run_time = 0;
+	kthreads_arr[kthreads_arr_used_size].run.switch_count = 0;
+	kthreads_arr[kthreads_arr_used_size].run.last_run = 0;
+#endif
+#ifdef STATIC_RTOS_EDF_PRIORITY
+	kthreads_arr[kthreads_arr_used_size].deadline = 0;
+#endif
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+	kthreads_arr[kthreads_arr_used_size].quantum = STATIC_RTOS_QUANTUM_TICKS;
+	kthreads_arr[kthreads_arr_used_size].quantum_left = 0;
+#endif
+#ifdef STATIC_RTOS_THREAD_BUDGET
+	kthreads_arr[kthreads_arr_used_size].budget = 0;
+	kthreads_arr[kthreads_arr_used_size].throttled = 0;
+#endif
+	kthread_make_ready(&kthreads_arr[kthreads_arr_used_size]);
 
 	kthreads_arr_used_size++;
 
@@ -119,6 +294,8 @@ kthread_create_static(void (*func)(void *), void *args, void *stack,
 int
 kthread_suspend(int id)
 {
+	int interrupts;
+
 	if (id < 0 || (size_t)id > kthreads_arr_used_size)
 		return 1;
 
@@ -129,7 +306,21 @@ kthread_suspend(int id)
 			return 1;
 	}
 
-	kthreads_arr[K_ID_TO_INDEX(id)].status = SUSPENDED;
+	/* the tick changes the ready lists too */
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	if (kthreads_arr[K_ID_TO_INDEX(id)].status == BLOCKED) {
+		if (interrupts)
+			PORT_ENABLE_INTERRUPTS();
+		return 1;
+	}
+
+	kthread_make_suspended(&kthreads_arr[K_ID_TO_INDEX(id)]);
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
 
 	if (id == kcurrent_thread_id && !PORT_IS_ATOMIC())
 		return kyield();
@@ -140,22 +331,124 @@ kthread_suspend(int id)
 int
 kthread_unsuspend(int id)
 {
+	struct kthread_t *thread;
+	int interrupts, preempts;
+
 	if (id <= 0 || (size_t)id > kthreads_arr_used_size)
 		return 1;
-	
-	kthreads_arr[K_ID_TO_INDEX(id)].status = READY;
-	if (kthreads_arr[K_ID_TO_INDEX(id)].priority >
-	    kthreads_arr[K_ID_TO_INDEX(kcurrent_thread_id)].priority &&
-	    !PORT_IS_ATOMIC())
+
+	if (kthreads_arr[K_ID_TO_INDEX(id)].status == BLOCKED)
+		return 1;
+
+	thread = &kthreads_arr[K_ID_TO_INDEX(id)];
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	/* a sleeping thread is woken up early */
+	if (thread->wake_scheduled == SLEEP_SCHEDULED)
+		ksleep_list_remove(thread);
+	kthread_make_ready(thread);
+
+	/* from a isr the switch happens in kisr_exit, like for kthread_wake */
+	preempts = kthread_preempts_current(thread);
+	if (preempts)
+		kswitch_pending = 1;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	if (preempts && kcurrent_thread_id > 0 && !PORT_IS_ATOMIC())
 		kyield();
 
 	return 0;
 }
 
+int
+kthread_notify(int id)
+{
+	int ret, woken, interrupts;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	woken = 0;
+	ret = kthread_notify_from_isr(id, &woken);
+	if (woken)
+		kreschedule();
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+int
+kthread_notify_from_isr(int id, int *higher_priority_woken)
+{
+	int interrupts;
+	struct kthread_t *thread;
+
+	thread = kthread_from_id(id);
+	if (!thread)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	if (thread->notify_count == UINT16_MAX) {
+		if (interrupts)
+			PORT_ENABLE_INTERRUPTS();
+		return 1;
+	}
+
+	thread->notify_count++;
+	if (thread->notify_waiter) {
+		kthread_wake(thread, KWAIT_SUCCESS);
+		if (higher_priority_woken && kthread_preempts_current(thread))
+			*higher_priority_woken = 1;
+	}
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+uint16_t
+kthread_notify_take(int clear_count, kticktype_t tick_timeout)
+{
+	int interrupts;
+	uint16_t count;
+	struct kthread_t *thread;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	thread = kthread_current();
+	if (thread && thread->notify_count == 0 && tick_timeout != 0)
+		(void)kthread_block(&thread->notify_waiter, tick_timeout);
+
+	count = thread ? thread->notify_count : 0;
+	if (count)
+		thread->notify_count = clear_count ? 0 : count - 1;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return count;
+}
+
 int
 kscheduler_start(void)
 {
-	int i;
+#ifdef STATIC_RTOS_THREAD_STATS
+	size_t i;
+#endif
 
 	if (kstarted_scheduler)
 		return 1;
@@ -166,16 +459,31 @@ kscheduler_start(void)
 	if (kmake_context_for_all_threads())
 		return 1;
 
+#ifdef STATIC_RTOS_THREAD_STATS
+	/* threads that didn't run yet count from here */
+	port_timestamp_start();
+	krun_start_time = port_timestamp();
+	krun_switch_time = krun_start_time;
+	kscheduler_run.last_run = krun_start_time;
+	for (i = 0; i < kthreads_arr_used_size; i++)
+		kthreads_arr[i].run.last_run = krun_start_time;
+#endif
+
 	kstarted_scheduler = 1;
-	while (1) {
-		i = get_next_id();
-		if (i < 0)
-			i = 0;
-		if (kswitch_to_thread_by_id(i) == -1) {
-			/* TODO: error handler */
-			printf("switch error\n");
-		}
+
+	/* the idle thread is the context that was saved above, moved to its
+	 * own stack if there is one
+	 */
+	if (kidle_stack) {
+		port_makecontext(&kscheduler_context, kidle_stack,
+				 kidle_stack_size, &kscheduler_context,
+				 kidle_thread, NULL);
+		port_setcontext(&kscheduler_context);
+		return 1;
 	}
+
+	kidle_thread(NULL);
+	return 1;
 }
 
 int
@@ -184,27 +492,65 @@ kscheduler_has_started(void)
 	return kstarted_scheduler;
 }
 
-/* TODO: critical blocks */
+int
+kscheduler_has_ready_thread(void)
+{
+	return khighest_ready_priority() >= 0;
+}
+
 int
 kyield(void)
 {
+	int ret, interrupts;
+	struct kthread_t *current;
+
 	/* this function can also be used to yield from a isr or when interrupts
 	 * are disabled
 	 */
 	if (!kstarted_scheduler || kcurrent_thread_id < 0)
 		return 1;
-	
-	return kswitch_to_thread_by_id(0);
+
+	/* the scheduler loop picks the next thread by itself */
+	if (kcurrent_thread_id == 0)
+		return 0;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	/* round-robin: the next thread of the same priority becomes the head
+	 * of the ready list, so it will be chosen instead of this one. The
+	 * EDF band stays sorted by deadline
+	 */
+	current = &kthreads_arr[K_ID_TO_INDEX(kcurrent_thread_id)];
+	if (kready_lists[current->priority] == current &&
+	    !K_IS_EDF(current->priority))
+		kready_lists[current->priority] = current->ready_next;
+
+	/* switch straight to the next thread. Only when no thread is READY is
+	 * the scheduler context (id 0) used
+	 */
+	ret = kswitch_to_thread_by_id(get_next_id());
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
 }
 
 int
 kenable_tick_interrupt(void)
 {
-	return port_enable_tick_interrupt();
+	int ret;
+
+	ret = port_enable_tick_interrupt();
+	ktick_enabled = !ret;
+
+	return ret;
 }
 
 int
-ksleep_for_ticks(uint16_t ticks_count)
+ksleep_for_ticks(kticktype_t ticks_count)
 {
 	int id, ret, interrupts;
 	if (!kstarted_scheduler)
@@ -222,19 +568,46 @@ ksleep_for_ticks(uint16_t ticks_count)
 	if (interrupts)
 		PORT_DISABLE_INTERRUPTS();
 	
-	if (UINT16_MAX - ktickcount < ticks_count) {
-		kthreads_arr[K_ID_TO_INDEX(id)].wake_scheduled = SLEEP_SCHEDULED_OVERFLOW;
-		kthreads_arr[K_ID_TO_INDEX(id)].wake_up_at = ktickcount + ticks_count;
-	} else {
-		kthreads_arr[K_ID_TO_INDEX(id)].wake_scheduled = SLEEP_SCHEDULED;
-		kthreads_arr[K_ID_TO_INDEX(id)].wake_up_at = ktickcount + ticks_count;
-	}
+	ret = ksleep_current(ticks_count);
 
-	/* using this instead of suspend */
-	kthreads_arr[K_ID_TO_INDEX(id)].status = SUSPENDED;
-	ret = kyield();
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+int
+ksleep_until(kticktype_t *last_wake, kticktype_t period)
+{
+	ksignedticktype_t ticks_count;
+	int ret, interrupts;
+
+	if (!kstarted_scheduler || !last_wake)
+		return 1;
+
+	if (kcurrent_thread_id <= 0)
+		return 1;
+
+	/* the tick must not move between reading it and sleeping, or the
+	 * thread would wake up a tick late
+	 */
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
 
-	kthreads_arr[K_ID_TO_INDEX(id)].wake_scheduled = 0;
+	*last_wake += period;
+	ticks_count = KTICK_DIFF(*last_wake, ktickcount);
+#ifdef STATIC_RTOS_EDF_PRIORITY
+	/* the deadline of the work after the wake-up is the next one */
+	kthread_change_deadline(kthread_current(), *last_wake + period);
+#endif
+	ret = 0;
+	if (ticks_count > 0)
+		ret = ksleep_current((kticktype_t)ticks_count);
+#ifdef STATIC_RTOS_EDF_PRIORITY
+	else
+		kreschedule();
+#endif
 
 	if (interrupts)
 		PORT_ENABLE_INTERRUPTS();
@@ -242,149 +615,560 @@ ksleep_for_ticks(uint16_t ticks_count)
 	return ret;
 }
 
+kticktype_t
+kget_tickcount(void)
+{
+	int interrupts;
+	kticktype_t tickcount;
+
+	/* it may take more than one load on 8 bit cpus */
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	tickcount = ktickcount;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return tickcount;
+}
+
 int
 kincrease_tickcount(void)
 {
-	int ret;
-	size_t i;
+	int ret, interrupts;
 
 	if (!kstarted_scheduler)
 		return 0;
-	
-	ktickcount++;
-	
-	if (ktickcount == 0) {
-		for (i = 0; i < kthreads_arr_used_size; i++) {
-			if (kthreads_arr[i].wake_scheduled !=
-			    SLEEP_SCHEDULED_OVERFLOW)
-				continue;
-			kthreads_arr[i].wake_scheduled = SLEEP_SCHEDULED;
-		}
-	}
 
-	ret = 0;
-	for (i = 0; i < kthreads_arr_used_size; i++) {
-		if (kthreads_arr[i].wake_scheduled != 1)
-			continue;
-		if (kthreads_arr[i].wake_up_at <= ktickcount) {
-			kthreads_arr[i].wake_scheduled = 0;
-			kthread_unsuspend(kthreads_arr[i].id);
-			/* TODO: check if the priority is higher or equal */
-			ret = 1;
-		}
-	}
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	ret = kadvance_tickcount(1);
 
-	/* TODO: check for mutexes */
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
 
 	return ret;
 }
 
-#if 0
-int
-kenable_tick_interrupt(void)
+void
+kisr_enter(void)
 {
-	PORT_ENABLE_INTERRUPTS();
+	KTRACE(KTRACE_ISR_ENTER, kcurrent_thread_id, kisr_nesting);
+	kisr_nesting++;
 }
 
-int
-KARE_INTERRUPTS_ENABLED(void)
+void
+kisr_exit(void)
 {
-	return PORT_ARE_INTERRUPTS_ENABLED();
+	if (kisr_nesting)
+		kisr_nesting--;
+	KTRACE(KTRACE_ISR_EXIT, kcurrent_thread_id, kisr_nesting);
+
+	if (!kisr_nesting && kswitch_pending)
+		port_request_switch();
 }
 
-int
-KBEGIN_ATOMIC(void)
+struct kthread_t *
+kthread_current(void)
 {
+	if (kcurrent_thread_id <= 0)
+		return NULL;
+
+	return &kthreads_arr[K_ID_TO_INDEX(kcurrent_thread_id)];
 }
 
-int
-KEND_ATOMIC(void)
+struct kthread_t *
+kthread_from_id(int id)
 {
+	if (id <= 0 || (size_t)id > kthreads_arr_used_size)
+		return NULL;
+
+	return &kthreads_arr[K_ID_TO_INDEX(id)];
 }
 
 int
-KIS_ATOMIC(void)
+kthread_block(struct kthread_t **wait_list, kticktype_t tick_timeout)
 {
-	return PORT_IS_ATOMIC();
-}
-#endif
+	struct kthread_t *thread;
 
-/**
- * This is a internal function used to make the context of all threads.
- * It is called at the beginning of kstart_scheduler
- *
- * @return If port_getcontext fails, then it will return 1, and 0 otherwise
- */
-static int
-kmake_context_for_all_threads(void)
-{
-	size_t i;
+	thread = kthread_current();
+	if (!thread)
+		return KWAIT_TIMEOUT;
 
-	for (i = 0; i < kthreads_arr_used_size; i++) {
-		if (port_getcontext(&kthreads_arr[i].context) != 0)
-			return 1;
-		port_makecontext(&kthreads_arr[i].context,
-				 kthreads_arr[i].stack,
-				 kthreads_arr[i].stack_size,
-				 &kscheduler_context,
-				 kthreads_arr[i].func,
-				 kthreads_arr[i].args);
+	KTRACE(KTRACE_BLOCK, thread->id, 0);
+	kwait_list_insert(wait_list, thread);
+	if (tick_timeout != KWAIT_FOREVER) {
+		ksleep_list_insert(thread, tick_timeout);
+		thread->wake_scheduled = WAIT_SCHEDULED;
 	}
 
-	return 0;
+	kthread_make_suspended(thread);
+	thread->status = BLOCKED;
+	thread->wait_result = KWAIT_SUCCESS;
+	kyield();
+
+	return thread->wait_result;
 }
 
-/**
- * This is a internal function used inside of the scheduler function to get the
- * id of the next thread to execute
- *
- * @return 0 if there is no READY thread
- *	   the id of the next thread to run
- */
-static int
-get_next_id(void)
+void
+kthread_wake(struct kthread_t *thread, int result)
 {
-	size_t i, last_run_index, first_index;
-	uint8_t max_priority, set_last_run_index;
+	if (thread->wait_list)
+		kwait_list_remove(thread);
+	if (thread->wake_scheduled != NO_REASON)
+		ksleep_list_remove(thread);
+
+	thread->wait_result = result;
+	KTRACE(KTRACE_WAKE, thread->id, result);
+	kthread_make_ready(thread);
+
+	if (kcurrent_thread_id > 0 && kthread_runs_before(thread,
+	    &kthreads_arr[K_ID_TO_INDEX(kcurrent_thread_id)]))
+		kswitch_pending = 1;
+}
 
-	max_priority = 0;
-	set_last_run_index = 0;
-	first_index = 0;
-	for (i = 0; i < kthreads_arr_used_size; i++) {
-		if (kthreads_arr[i].status == SUSPENDED)
-			continue;
-		if (kthreads_arr[i].priority > max_priority) {
-			max_priority = kthreads_arr[i].priority;
-			first_index = i;
+void
+kthread_set_priority(struct kthread_t *thread, uint8_t priority)
+{
+	struct kthread_t **wait_list;
+
+	if (thread->priority == priority)
+		return;
+
+	KTRACE(KTRACE_PRIORITY, thread->id, priority);
+	if (thread->status == READY) {
+		kready_list_remove(thread);
+		thread->priority = priority;
+		kready_list_insert(thread);
+	} else if (thread->wait_list) {
+		wait_list = thread->wait_list;
+		kwait_list_remove(thread);
+		thread->priority = priority;
+		kwait_list_insert(wait_list, thread);
+	} else {
+		thread->priority = priority;
+	}
+}
+
+int
+kthread_preempts_current(const struct kthread_t *thread)
+{
+	struct kthread_t *current;
+
+	current = kthread_current();
+	return !current || kthread_runs_before(thread, current);
+}
+
+void
+kreschedule(void)
+{
+	struct kthread_t *thread;
+	int priority;
+
+	/* inside a isr the switch waits for kisr_exit */
+	if (kisr_nesting)
+		return;
+
+	thread = kthread_current();
+	priority = khighest_ready_priority();
+	if (thread && priority >= 0 &&
+	    kthread_runs_before(kready_lists[priority], thread))
+		kyield();
+}
+
+#ifdef STATIC_RTOS_EDF_PRIORITY
+
+int
+kthread_set_deadline(int id, kticktype_t deadline)
+{
+	int interrupts;
+
+	if (id < 0 || (size_t)id > kthreads_arr_used_size)
+		return 1;
+
+	if (id == 0) {
+		id = kcurrent_thread_id;
+
+		if (id <= 0)
+			return 1;
+	}
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	kthread_change_deadline(&kthreads_arr[K_ID_TO_INDEX(id)], deadline);
+	if (kstarted_scheduler)
+		kreschedule();
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+#endif /* #ifdef STATIC_RTOS_EDF_PRIORITY */
+
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+
+int
+kthread_set_quantum(int id, kticktype_t ticks_count)
+{
+	if (id < 0 || (size_t)id > kthreads_arr_used_size)
+		return 1;
+
+	if (id == 0) {
+		id = kcurrent_thread_id;
+
+		if (id <= 0)
+			return 1;
+	}
+
+	/* the current quantum ends as it was, the next one is the new one */
+	kthreads_arr[K_ID_TO_INDEX(id)].quantum = ticks_count;
+
+	return 0;
+}
+
+#endif /* #ifdef STATIC_RTOS_QUANTUM_TICKS */
+
+#ifdef STATIC_RTOS_THREAD_BUDGET
+
+int
+kthread_set_budget(int id, kticktype_t budget, kticktype_t period,
+		   uint8_t throttle_priority)
+{
+	struct kthread_t *thread, **prev;
+	int interrupts;
+
+	if (id < 0 || (size_t)id > kthreads_arr_used_size)
+		return 1;
+
+	if (id == 0) {
+		id = kcurrent_thread_id;
+
+		if (id <= 0)
+			return 1;
+	}
+
+	thread = &kthreads_arr[K_ID_TO_INDEX(id)];
+	if (budget > period || (budget && (throttle_priority == 0 ||
+	    throttle_priority >= thread->base_priority)))
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	if (thread->throttled) {
+		for (prev = &kthrottled_list; *prev != thread;
+		     prev = &(*prev)->throttled_next)
+			;
+		*prev = thread->throttled_next;
+		thread->throttled = 0;
+		kmutex_update_priority(thread);
+	}
+
+	thread->budget = budget;
+	thread->budget_period = period;
+	thread->budget_left = budget;
+	thread->budget_period_end = ktickcount + period;
+	thread->throttle_priority = throttle_priority;
+
+	if (kstarted_scheduler)
+		kreschedule();
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+#endif /* #ifdef STATIC_RTOS_THREAD_BUDGET */
+
+#ifdef STATIC_RTOS_THREAD_STATS
+
+size_t
+kthread_get_stats(struct kthread_stats_t *stats, size_t capacity,
+		  uint32_t *total_time)
+{
+	struct krun_time_t *run;
+	size_t i;
+	uint32_t now;
+	int interrupts;
+
+	if (!stats)
+		return 0;
+
+	/* all of the entries are taken at the same time */
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	now = port_timestamp();
+	for (i = 0; i < capacity && i <= kthreads_arr_used_size; i++) {
+		run = krun_time_of(i);
+		stats[i].id = i;
+		stats[i].run_time = run->run_time;
+		stats[i].switch_count = run->switch_count;
+		stats[i].since_last_run = now - run->last_run;
+		if (i == 0) {
+			stats[i].status = READY;
+			stats[i].priority = 0;
+		} else {
+			stats[i].status = kthreads_arr[K_ID_TO_INDEX(i)].status;
+			stats[i].priority =
+				kthreads_arr[K_ID_TO_INDEX(i)].priority;
 		}
-		if (kthreads_arr[i].priority == max_priority &&
-		    kthreads_arr[i].last_run) {
-			last_run_index = i;
-			set_last_run_index = 1;
+
+		if ((int)i == kcurrent_thread_id) {
+			stats[i].status = RUNNING;
+			stats[i].run_time += now - krun_switch_time;
+			stats[i].since_last_run = 0;
 		}
 	}
 
-	if (!max_priority)
+	if (total_time)
+		*total_time = now - krun_start_time;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return i;
+}
+
+#endif /* #ifdef STATIC_RTOS_THREAD_STATS */
+
+#ifdef STATIC_RTOS_STACK_CHECK
+
+size_t
+kthread_stack_high_water(int id)
+{
+	const uint8_t *stack;
+	size_t unused, size;
+
+	if (!kstarted_scheduler)
 		return 0;
-	
-	if (!set_last_run_index)
-		return first_index + 1;
-	
-	for (i = last_run_index + 1; i < kthreads_arr_used_size; i++) {
-		if (kthreads_arr[i].status == SUSPENDED)
-			continue;
-		if (kthreads_arr[i].priority == max_priority)
-			return i + 1;
+
+	if (id == 0)
+		id = kcurrent_thread_id;
+
+	if (id <= 0 || (size_t)id > kthreads_arr_used_size)
+		return 0;
+
+	/* the stacks grow down, from the end to the start */
+	stack = kthreads_arr[K_ID_TO_INDEX(id)].stack;
+	size = kthreads_arr[K_ID_TO_INDEX(id)].stack_size;
+	for (unused = 0; unused < size && stack[unused] == KSTACK_PAINT;
+	     unused++)
+		;
+
+	return size - unused;
+}
+
+void
+kset_stack_overflow_hook(void (*hook)(int id))
+{
+	kstack_overflow_hook = hook;
+}
+
+#endif /* #ifdef STATIC_RTOS_STACK_CHECK */
+
+#if 0
+int
+kenable_tick_interrupt(void)
+{
+	PORT_ENABLE_INTERRUPTS();
+}
+
+int
+KARE_INTERRUPTS_ENABLED(void)
+{
+	return PORT_ARE_INTERRUPTS_ENABLED();
+}
+
+int
+KBEGIN_ATOMIC(void)
+{
+}
+
+int
+KEND_ATOMIC(void)
+{
+}
+
+int
+KIS_ATOMIC(void)
+{
+	return PORT_IS_ATOMIC();
+}
+#endif
+
+/**
+ * This is a internal function that makes the context of one thread. With
+ * -DSTATIC_RTOS_STACK_CHECK it paints the stack first. It is separate from the
+ * loop in kmake_context_for_all_threads so that no loop index lives across
+ * port_getcontext, which may return twice like setjmp
+ *
+ * @param thread The thread
+ *
+ * @return If port_getcontext fails, then it will return 1, and 0 otherwise
+ */
+static int
+kmake_context(struct kthread_t *thread)
+{
+#ifdef STATIC_RTOS_STACK_CHECK
+	/* before port_makecontext, which may put the first frame on the stack */
+	memset(thread->stack, KSTACK_PAINT, thread->stack_size);
+#endif
+	if (port_getcontext(&thread->context) != 0)
+		return 1;
+	port_makecontext(&thread->context, thread->stack, thread->stack_size,
+			 &kscheduler_context, kthread_entry, thread);
+
+	return 0;
+}
+
+/**
+ * This is a internal function where every thread starts. It runs the function
+ * of the thread and, if that returns, suspends the thread, which switches
+ * away from it. Unsuspending it only suspends it again, since its function is
+ * done. So the successor context given to port_makecontext is never used: it
+ * would resume the idle thread in the middle of a switch, with the thread
+ * still READY and current
+ *
+ * @param args The thread
+ */
+static void
+kthread_entry(void *args)
+{
+	struct kthread_t *thread;
+
+	thread = args;
+	thread->func(thread->args);
+
+	while (1)
+		(void)kthread_suspend(0);
+}
+
+/**
+ * This is a internal function used to make the context of all threads.
+ * It is called at the beginning of kstart_scheduler
+ *
+ * @return If port_getcontext fails, then it will return 1, and 0 otherwise
+ */
+static int
+kmake_context_for_all_threads(void)
+{
+	size_t i;
+
+	for (i = 0; i < kthreads_arr_used_size; i++) {
+		if (kmake_context(&kthreads_arr[i]))
+			return 1;
 	}
 
-	return first_index + 1;
+	return 0;
 }
 
 /**
- * This is a internal function used to switch the context from the scheduler to
- * the thread with id = id. It sets the global variable kcurrent_thread_id.
+ * This is a internal function that is the body of the idle thread (id 0).
+ * Threads switch directly between each other, so it only runs when no thread
+ * is READY. It calls the idle hook and puts the cpu
+ * to sleep until a interrupt comes, with port_idle or, with
+ * -DSTATIC_RTOS_TICKLESS_IDLE, with the tick stopped until the first sleeping
+ * thread has to wake up. If interrupts are disabled nothing could wake it up,
+ * so it only checks for READY threads again
  *
- * @param id The id of the thread to switch context to
+ * @param args Not used
+ */
+static void
+kidle_thread(void *args)
+{
+	int i, interrupts;
+
+	(void)args;
+
+	while (1) {
+		if (kidle_hook)
+			kidle_hook();
+
+		interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+		if (interrupts)
+			PORT_DISABLE_INTERRUPTS();
+
+		i = get_next_id();
+		if (i > 0 && kswitch_to_thread_by_id(i) == -1) {
+			/* TODO: error handler */
+			printf("switch error\n");
+		}
+#ifdef STATIC_RTOS_TICKLESS_IDLE
+		else if (i == 0 && ktick_enabled && interrupts)
+			kadvance_tickcount(port_suppress_ticks_and_sleep(
+				ksleep_list && ksleep_list->sleep_delta <
+					       UINT16_MAX ?
+				(uint16_t)ksleep_list->sleep_delta :
+				UINT16_MAX));
+#endif /* #ifdef STATIC_RTOS_TICKLESS_IDLE */
+		else if (i == 0 && interrupts)
+			port_idle();
+
+		if (interrupts)
+			PORT_ENABLE_INTERRUPTS();
+	}
+}
+
+/**
+ * This is a internal function used inside of the scheduler function to get the
+ * id of the next thread to execute. The highest priority that has a READY
+ * thread is found from the ready bitmaps and the head of its ready list is the
+ * next thread to run, so this doesn't depend on the number of threads
+ *
+ * @return 0 if there is no READY thread
+ *	   the id of the next thread to run
+ */
+static int
+get_next_id(void)
+{
+	int priority;
+
+	priority = khighest_ready_priority();
+	if (priority < 0)
+		return 0;
+
+	return kready_lists[priority]->id;
+}
+
+/**
+ * This is a internal function that finds the highest priority with a READY
+ * thread from the ready bitmaps
+ *
+ * @return The priority or -1 if there is no READY thread
+ */
+static int
+khighest_ready_priority(void)
+{
+	uint8_t group;
+
+	if (!kready_group_bitmap)
+		return -1;
+
+	group = khighest_bit32(kready_group_bitmap);
+
+	return group * 8 + khighest_bit8(kready_bitmap[group]);
+}
+
+/**
+ * This is a internal function used to switch the context from the current
+ * thread (or the scheduler) to the thread with id = id with a single
+ * port_swapcontext. It sets the global variable kcurrent_thread_id.
+ * Must be called with interrupts disabled
+ *
+ * @param id The id of the thread to switch context to. 0 switches to the
+ *	     scheduler context
  *
  * @return same as port_swapcontext
  */
@@ -397,42 +1181,596 @@ kswitch_to_thread_by_id(int id)
 	if (id < 0)
 		return 1;
 
+	/* this is the switch that was pending, or a better one */
+	kswitch_pending = 0;
+
 	old_id = kcurrent_thread_id;
 	kcurrent_thread_id = id;
 
 	if (old_id == kcurrent_thread_id)
 		return 0;
+
+#ifdef STATIC_RTOS_STACK_CHECK
+	if (old_id != 0)
+		kstack_check(&kthreads_arr[K_ID_TO_INDEX(old_id)]);
+#endif
+
+	KTRACE(KTRACE_SWITCH, id, old_id);
+#ifdef STATIC_RTOS_THREAD_STATS
+	krun_time_switch(old_id, id);
+#endif
 	
 	if (old_id == 0)
 		old_context = &kscheduler_context;
 	else
 		old_context = &kthreads_arr[K_ID_TO_INDEX(old_id)].context;
 
-	if (id == 0)
+	if (id == 0) {
 		new_context = &kscheduler_context;
-	else
+	} else {
 		new_context = &kthreads_arr[K_ID_TO_INDEX(id)].context;
-
-	if (id) {
-		make_0_last_run_for_priority(kthreads_arr[K_ID_TO_INDEX(id)].priority);
-		kthreads_arr[K_ID_TO_INDEX(id)].last_run = 1;
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+		/* a new quantum every time the thread is switched to */
+		kthreads_arr[K_ID_TO_INDEX(id)].quantum_left =
+			kthreads_arr[K_ID_TO_INDEX(id)].quantum;
+#endif
 	}
 
 	return port_swapcontext(old_context, new_context);
 }
 
 /**
- * This is a internal function that sets the .last_run field of all of the
- * threads to 0. This is done to ensure a round-robin like execution for threads
- * with the same priority
+ * This is a internal function that appends thread to the tail of the ready list
+ * of its priority (right before the head) and marks the priority as ready in
+ * the bitmaps. In the EDF band it goes before the first thread with a later
+ * deadline instead, so the head has the earliest one
+ *
+ * @param thread The thread to insert. It must not already be in a ready list
  */
 static void
-make_0_last_run_for_priority(uint8_t priority)
+kready_list_insert(struct kthread_t *thread)
 {
-	size_t i;
+	struct kthread_t *head, *next;
+	uint8_t priority;
+
+	priority = thread->priority;
+	head = kready_lists[priority];
+
+	if (!head) {
+		thread->ready_next = thread;
+		thread->ready_prev = thread;
+		kready_lists[priority] = thread;
+		kready_bitmap[priority / 8] |= 1 << (priority % 8);
+		kready_group_bitmap |= (uint32_t)1 << (priority / 8);
+		return;
+	}
 
-	for (i = 0; i < kthreads_arr_used_size; i++)
-		if (kthreads_arr[i].priority == priority)
-			kthreads_arr[i].last_run = 0;
+	next = head;
+	if (K_IS_EDF(priority)) {
+		while (!kthread_runs_before(thread, next)) {
+			next = next->ready_next;
+			if (next == head)
+				break;
+		}
+		if (next == head && kthread_runs_before(thread, head))
+			kready_lists[priority] = thread;
+	}
+
+	thread->ready_next = next;
+	thread->ready_prev = next->ready_prev;
+	next->ready_prev->ready_next = thread;
+	next->ready_prev = thread;
+}
+
+/**
+ * This is a internal function that tells if thread a has to run before thread
+ * b: it has a higher priority or, in the EDF band, a earlier deadline
+ */
+static int
+kthread_runs_before(const struct kthread_t *a, const struct kthread_t *b)
+{
+	if (a->priority != b->priority)
+		return a->priority > b->priority;
+
+#ifdef STATIC_RTOS_EDF_PRIORITY
+	if (K_IS_EDF(a->priority))
+		return KTICK_DIFF(a->deadline, b->deadline) < 0;
+#endif
+
+	return 0;
+}
+
+#ifdef STATIC_RTOS_EDF_PRIORITY
+
+/**
+ * This is a internal function that sets the deadline of thread, moving it in
+ * its ready list if it is READY. Must be called with interrupts disabled
+ */
+static void
+kthread_change_deadline(struct kthread_t *thread, kticktype_t deadline)
+{
+	if (thread->status == READY && K_IS_EDF(thread->priority)) {
+		kready_list_remove(thread);
+		thread->deadline = deadline;
+		kready_list_insert(thread);
+	} else {
+		thread->deadline = deadline;
+	}
+}
+
+#endif /* #ifdef STATIC_RTOS_EDF_PRIORITY */
+
+/**
+ * This is a internal function that unlinks thread from the ready list of its
+ * priority. If the list becomes empty, the priority is cleared from the bitmaps
+ *
+ * @param thread The thread to remove. It must be in a ready list
+ */
+static void
+kready_list_remove(struct kthread_t *thread)
+{
+	uint8_t priority;
+
+	priority = thread->priority;
+
+	if (thread->ready_next == thread) {
+		kready_lists[priority] = NULL;
+		kready_bitmap[priority / 8] &= ~(1 << (priority % 8));
+		if (!kready_bitmap[priority / 8])
+			kready_group_bitmap &= ~((uint32_t)1 << (priority / 8));
+	} else {
+		thread->ready_prev->ready_next = thread->ready_next;
+		thread->ready_next->ready_prev = thread->ready_prev;
+		if (kready_lists[priority] == thread)
+			kready_lists[priority] = thread->ready_next;
+	}
+
+	thread->ready_next = NULL;
+	thread->ready_prev = NULL;
+}
+
+/**
+ * This is a internal function that sets the status of thread to READY and puts
+ * it on its ready list if it wasn't already there
+ */
+static void
+kthread_make_ready(struct kthread_t *thread)
+{
+	if (thread->status != READY) {
+		kready_list_insert(thread);
+		KTRACE(KTRACE_READY, thread->id, 0);
+	}
+	thread->status = READY;
+}
+
+/**
+ * This is a internal function that sets the status of thread to SUSPENDED and
+ * takes it off its ready list if it was there
+ */
+static void
+kthread_make_suspended(struct kthread_t *thread)
+{
+	if (thread->status == READY)
+		kready_list_remove(thread);
+	thread->status = SUSPENDED;
+	KTRACE(KTRACE_SUSPEND, thread->id, 0);
+}
+
+/**
+ * This is a internal function that puts thread in the sleep list so that it
+ * wakes up after ticks_count ticks. The list is walked from the head,
+ * subtracting the deltas, until the place of the thread is found; the thread
+ * after it has its delta reduced by the remaining ticks. Threads that wake up
+ * at the same tick stay in the order they went to sleep
+ *
+ * @param thread The thread to put to sleep. It must not be in the sleep list
+ * @param ticks_count The amount of ticks to sleep for
+ */
+static void
+ksleep_list_insert(struct kthread_t *thread, kticktype_t ticks_count)
+{
+	struct kthread_t *prev, *next;
+
+	prev = NULL;
+	next = ksleep_list;
+	while (next && next->sleep_delta <= ticks_count) {
+		ticks_count -= next->sleep_delta;
+		prev = next;
+		next = next->sleep_next;
+	}
+
+	thread->sleep_delta = ticks_count;
+	thread->sleep_prev = prev;
+	thread->sleep_next = next;
+	thread->wake_scheduled = SLEEP_SCHEDULED;
+
+	if (next) {
+		next->sleep_delta -= ticks_count;
+		next->sleep_prev = thread;
+	}
+	if (prev)
+		prev->sleep_next = thread;
+	else
+		ksleep_list = thread;
+}
+
+/**
+ * This is a internal function that puts the current thread to sleep for
+ * ticks_count ticks. Must be called with interrupts disabled, from a thread
+ *
+ * @return same as kyield
+ */
+static int
+ksleep_current(kticktype_t ticks_count)
+{
+	struct kthread_t *thread;
+
+	thread = &kthreads_arr[K_ID_TO_INDEX(kcurrent_thread_id)];
+
+	KTRACE(KTRACE_SLEEP, thread->id, KTRACE_TICKS(ticks_count));
+	ksleep_list_insert(thread, ticks_count);
+
+	/* using this instead of suspend */
+	kthread_make_suspended(thread);
+	return kyield();
+}
+
+/**
+ * This is a internal function that takes thread out of the sleep list. Its
+ * remaining delta is given to the thread after it so the wake-up time of the
+ * others doesn't change
+ *
+ * @param thread The thread to remove. It must be in the sleep list
+ */
+static void
+ksleep_list_remove(struct kthread_t *thread)
+{
+	if (thread->sleep_next) {
+		thread->sleep_next->sleep_delta += thread->sleep_delta;
+		thread->sleep_next->sleep_prev = thread->sleep_prev;
+	}
+	if (thread->sleep_prev)
+		thread->sleep_prev->sleep_next = thread->sleep_next;
+	else
+		ksleep_list = thread->sleep_next;
+
+	thread->sleep_next = NULL;
+	thread->sleep_prev = NULL;
+	thread->sleep_delta = 0;
+	thread->wake_scheduled = NO_REASON;
+}
+
+/**
+ * This is a internal function that moves the tick count forward by
+ * ticks_count and wakes up the threads whose sleep ended. Only the head of the
+ * sleep list is counted down, the threads after it with a delta of 0 wake up
+ * at the same tick. Must be called with interrupts disabled
+ *
+ * @param ticks_count The amount of ticks that passed. More than 1 only after a
+ *		      tickless idle period
+ *
+ * @return Returns 1 if a new thread is readied and 0 otherwise
+ */
+static int
+kadvance_tickcount(kticktype_t ticks_count)
+{
+	int ret;
+	struct kthread_t *thread, *current;
+
+	ktickcount += ticks_count;
+	KTRACE(KTRACE_TICK, kcurrent_thread_id, KTRACE_TICKS(ticks_count));
+
+	ret = 0;
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+	ret = kquantum_advance(ticks_count);
+#endif
+#ifdef STATIC_RTOS_THREAD_BUDGET
+	ret |= kbudget_advance(ticks_count);
+#endif
+	while (ksleep_list) {
+		if (ksleep_list->sleep_delta > ticks_count) {
+			ksleep_list->sleep_delta -= ticks_count;
+			break;
+		}
+		ticks_count -= ksleep_list->sleep_delta;
+
+		thread = ksleep_list;
+		thread->sleep_delta = 0;
+		ksleep_list_remove(thread);
+		/* a wait on a kernel object that timed out */
+		if (thread->wait_list) {
+			kwait_list_remove(thread);
+			thread->wait_result = KWAIT_TIMEOUT;
+			KTRACE(KTRACE_WAKE, thread->id, KWAIT_TIMEOUT);
+		}
+		kthread_make_ready(thread);
+
+		/* a thread of the same priority takes its turn too, except
+		 * in the EDF band, where it waits for its deadline to be the
+		 * earliest, and when the current thread has a quantum, which
+		 * it waits for the end of
+		 */
+		current = kthread_current();
+		if (current &&
+		    (kthread_runs_before(thread, current) ||
+		     (thread->priority == current->priority &&
+		      !K_IS_EDF(thread->priority) &&
+		      !KQUANTUM_LEFT(current)))) {
+			kswitch_pending = 1;
+			ret = 1;
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * This is a internal function that puts thread on a wait list after the
+ * threads with a higher or equal priority
+ *
+ * @param wait_list The wait list of a kernel object
+ * @param thread The thread to insert. It must not be on a wait list
+ */
+static void
+kwait_list_insert(struct kthread_t **wait_list, struct kthread_t *thread)
+{
+	struct kthread_t *prev, *next;
+
+	prev = NULL;
+	next = *wait_list;
+	while (next && next->priority >= thread->priority) {
+		prev = next;
+		next = next->wait_next;
+	}
+
+	thread->wait_list = wait_list;
+	thread->wait_prev = prev;
+	thread->wait_next = next;
+
+	if (next)
+		next->wait_prev = thread;
+	if (prev)
+		prev->wait_next = thread;
+	else
+		*wait_list = thread;
+}
+
+/**
+ * This is a internal function that takes thread off the wait list it is on
+ */
+static void
+kwait_list_remove(struct kthread_t *thread)
+{
+	if (thread->wait_next)
+		thread->wait_next->wait_prev = thread->wait_prev;
+	if (thread->wait_prev)
+		thread->wait_prev->wait_next = thread->wait_next;
+	else
+		*thread->wait_list = thread->wait_next;
+
+	thread->wait_list = NULL;
+	thread->wait_next = NULL;
+	thread->wait_prev = NULL;
+}
+
+/**
+ * @return The index of the highest set bit of x. x must not be 0
+ */
+static uint8_t
+khighest_bit8(uint8_t x)
+{
+	if (x & 0xf0)
+		return 4 + khighest_bit_table[x >> 4];
+	return khighest_bit_table[x];
+}
+
+/**
+ * @return The index of the highest set bit of x. x must not be 0
+ */
+static uint8_t
+khighest_bit32(uint32_t x)
+{
+	if (x & 0xffff0000) {
+		if (x & 0xff000000)
+			return 24 + khighest_bit8(x >> 24);
+		return 16 + khighest_bit8(x >> 16);
+	}
+	if (x & 0xff00)
+		return 8 + khighest_bit8(x >> 8);
+	return khighest_bit8(x);
+}
+
+#ifdef STATIC_RTOS_THREAD_STATS
+
+/**
+ * This is a internal function that returns the run time statistics of the
+ * thread with the id id, or of the scheduler for 0
+ */
+static struct krun_time_t *
+krun_time_of(int id)
+{
+	if (id == 0)
+		return &kscheduler_run;
+
+	return &kthreads_arr[K_ID_TO_INDEX(id)].run;
+}
+
+/**
+ * This is a internal function that charges the time since the last switch to
+ * the context with the id old_id and counts the switch to the one with the id
+ * id. Must be called with interrupts disabled
+ */
+static void
+krun_time_switch(int old_id, int id)
+{
+	struct krun_time_t *old_run, *new_run;
+	uint32_t now;
+
+	now = port_timestamp();
+	old_run = krun_time_of(old_id);
+	new_run = krun_time_of(id);
+
+	old_run->run_time += now - krun_switch_time;
+	old_run->last_run = now;
+	new_run->switch_count++;
+	krun_switch_time = now;
+}
+
+#endif /* #ifdef STATIC_RTOS_THREAD_STATS */
+
+#ifdef STATIC_RTOS_STACK_CHECK
+
+/**
+ * This is a internal function that checks that the bottom
+ * STATIC_RTOS_STACK_CANARY_SIZE bytes of the stack of thread are still
+ * painted. If they aren't, the thread went past its stack and the overflow hook
+ * is called, or the cpu is halted with interrupts disabled if there is none.
+ * Must be called with interrupts disabled
+ */
+static void
+kstack_check(struct kthread_t *thread)
+{
+	const uint8_t *stack;
+	uint8_t i;
+
+	stack = thread->stack;
+	for (i = 0; i < STATIC_RTOS_STACK_CANARY_SIZE; i++) {
+		if (stack[i] == KSTACK_PAINT)
+			continue;
+
+		if (kstack_overflow_hook) {
+			kstack_overflow_hook(thread->id);
+			return;
+		}
+
+		/* the memory below the stack is gone, don't run on it */
+		PORT_DISABLE_INTERRUPTS();
+		while (1)
+			;
+	}
+}
+
+#endif /* #ifdef STATIC_RTOS_STACK_CHECK */
+
+#ifdef STATIC_RTOS_QUANTUM_TICKS
+
+/**
+ * This is a internal function that counts the ticks that passed off the
+ * quantum of the running thread. When the quantum ends and another thread of
+ * the same priority is READY, a switch to it becomes pending; kyield makes it
+ * the head of the ready list. If none is, the thread goes on running and the
+ * switch happens on the first tick after one becomes READY. Threads with a
+ * quantum of 0 and the EDF band are left alone. Must be called with
+ * interrupts disabled
+ *
+ * @param ticks_count The amount of ticks that passed
+ *
+ * @return Returns 1 if a switch became pending and 0 otherwise
+ */
+static int
+kquantum_advance(kticktype_t ticks_count)
+{
+	struct kthread_t *thread;
+
+	thread = kthread_current();
+	if (!thread || !thread->quantum || K_IS_EDF(thread->priority))
+		return 0;
+
+	if (thread->quantum_left > ticks_count) {
+		thread->quantum_left -= ticks_count;
+		return 0;
+	}
+	thread->quantum_left = 0;
+
+	if (thread->status != READY || thread->ready_next == thread)
+		return 0;
+
+	kswitch_pending = 1;
+	return 1;
+}
+
+#endif /* #ifdef STATIC_RTOS_QUANTUM_TICKS */
+
+#ifdef STATIC_RTOS_THREAD_BUDGET
+
+/**
+ * This is a internal function that charges the ticks that passed to the
+ * budget of the running thread, throttling it if it used the budget up, and
+ * gives their budget back to the throttled threads whose budget period ended.
+ * The tick is sampled: the thread that runs when it comes is charged the whole
+ * tick. Must be called with interrupts disabled, after the tick count moved
+ *
+ * @param ticks_count The amount of ticks that passed
+ *
+ * @return Returns 1 if a switch became pending and 0 otherwise
+ */
+static int
+kbudget_advance(kticktype_t ticks_count)
+{
+	struct kthread_t *thread, **prev;
+	int ret;
+
+	ret = 0;
+
+	thread = kthread_current();
+	if (thread && thread->budget && !thread->throttled) {
+		kbudget_replenish(thread);
+		if (thread->budget_left > ticks_count) {
+			thread->budget_left -= ticks_count;
+		} else {
+			thread->budget_left = 0;
+			thread->throttled = 1;
+			thread->throttled_next = kthrottled_list;
+			kthrottled_list = thread;
+			kmutex_update_priority(thread);
+		}
+	}
+
+	prev = &kthrottled_list;
+	while (*prev) {
+		thread = *prev;
+		if (KTICK_DIFF(ktickcount, thread->budget_period_end) < 0) {
+			prev = &thread->throttled_next;
+			continue;
+		}
+
+		*prev = thread->throttled_next;
+		thread->throttled = 0;
+		kbudget_replenish(thread);
+		kmutex_update_priority(thread);
+	}
+
+	/* the running thread may have been throttled or a throttled one
+	 * may be back above it
+	 */
+	thread = kthread_current();
+	if (thread && khighest_ready_priority() >= 0 &&
+	    kthread_runs_before(kready_lists[khighest_ready_priority()],
+				thread)) {
+		kswitch_pending = 1;
+		ret = 1;
+	}
+
+	return ret;
+}
+
+/**
+ * This is a internal function that refills the budget of thread if its budget
+ * period ended, and moves the end of the period past the current tick, on the
+ * grid of the first one. Must be called with interrupts disabled
+ */
+static void
+kbudget_replenish(struct kthread_t *thread)
+{
+	ksignedticktype_t late;
+
+	late = KTICK_DIFF(ktickcount, thread->budget_period_end);
+	if (late < 0)
+		return;
+
+	thread->budget_left = thread->budget;
+	thread->budget_period_end += ((kticktype_t)late / thread->budget_period +
+				      1) * thread->budget_period;
 }
 
+#endif /* #ifdef STATIC_RTOS_THREAD_BUDGET */
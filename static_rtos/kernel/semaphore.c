@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <static_rtos/kernel/semaphore.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+#include "internal.h"
+
+/* function definitions */
+
+int
+ksemaphore_create(struct ksemaphore_t *semaphore, uint16_t count,
+		  uint16_t max_count)
+{
+	if (!semaphore || !max_count || count > max_count)
+		return 1;
+
+	semaphore->count = count;
+	semaphore->max_count = max_count;
+	semaphore->waiters = NULL;
+
+	return 0;
+}
+
+int
+ksemaphore_take(struct ksemaphore_t *semaphore, kticktype_t tick_timeout)
+{
+	int ret, interrupts;
+	struct kthread_t *current;
+
+	if (!semaphore)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	current = kthread_current();
+	if (semaphore->count) {
+		semaphore->count--;
+		ret = 0;
+	} else if (tick_timeout == 0 || !current) {
+		ret = 1;
+	} else {
+		/* on success the count was handed straight to this thread */
+		ret = kthread_block(&semaphore->waiters, tick_timeout) !=
+		      KWAIT_SUCCESS;
+	}
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+int
+ksemaphore_give(struct ksemaphore_t *semaphore)
+{
+	int ret, woken, interrupts;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	woken = 0;
+	ret = ksemaphore_give_from_isr(semaphore, &woken);
+	if (woken)
+		kreschedule();
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+int
+ksemaphore_give_from_isr(struct ksemaphore_t *semaphore,
+			 int *higher_priority_woken)
+{
+	int ret, interrupts;
+	struct kthread_t *waiter;
+
+	if (!semaphore)
+		return 1;
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	waiter = semaphore->waiters;
+	if (waiter) {
+		kthread_wake(waiter, KWAIT_SUCCESS);
+		if (higher_priority_woken && kthread_preempts_current(waiter))
+			*higher_priority_woken = 1;
+		ret = 0;
+	} else if (semaphore->count < semaphore->max_count) {
+		semaphore->count++;
+		ret = 0;
+	} else {
+		ret = 1;
+	}
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return ret;
+}
+
+uint16_t
+ksemaphore_count(struct ksemaphore_t *semaphore)
+{
+	return semaphore ? semaphore->count : 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <static_rtos/kernel/stream.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+#include "internal.h"
+
+/* function declarations */
+
+static size_t kstream_copy_in(struct kstream_t *stream, const void *data,
+			      size_t size);
+static struct kthread_t *kstream_wake_reader(struct kstream_t *stream);
+
+/* function definitions */
+
+int
+kstream_create(struct kstream_t *stream, void *buffer, size_t size,
+	       size_t trigger_level)
+{
+	if (!stream || !buffer || size < 2 || (size & (size - 1)))
+		return 1;
+
+	/* the difference of the indexes must be able to hold size */
+	if ((size_t)(port_atomic_index_t)(size * 2 - 1) != size * 2 - 1)
+		return 1;
+
+	if (trigger_level == 0 || trigger_level > size)
+		return 1;
+
+	stream->buffer = buffer;
+	stream->mask = (port_atomic_index_t)(size - 1);
+	stream->write_index = 0;
+	stream->read_index = 0;
+	stream->trigger_level = (port_atomic_index_t)trigger_level;
+	stream->wanted = 0;
+	stream->reader = NULL;
+
+	return 0;
+}
+
+size_t
+kstream_write(struct kstream_t *stream, const void *data, size_t size)
+{
+	int interrupts;
+	size_t written;
+
+	if (!stream || !data)
+		return 0;
+
+	written = kstream_copy_in(stream, data, size);
+
+	/* only the wakeup needs interrupts disabled */
+	if (stream->reader) {
+		interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+		if (interrupts)
+			PORT_DISABLE_INTERRUPTS();
+
+		if (kstream_wake_reader(stream))
+			kreschedule();
+
+		if (interrupts)
+			PORT_ENABLE_INTERRUPTS();
+	}
+
+	return written;
+}
+
+size_t
+kstream_write_from_isr(struct kstream_t *stream, const void *data,
+		       size_t size, int *higher_priority_woken)
+{
+	int interrupts;
+	size_t written;
+	struct kthread_t *woken;
+
+	if (!stream || !data)
+		return 0;
+
+	written = kstream_copy_in(stream, data, size);
+
+	if (stream->reader) {
+		interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+		if (interrupts)
+			PORT_DISABLE_INTERRUPTS();
+
+		woken = kstream_wake_reader(stream);
+		if (woken && higher_priority_woken &&
+		    kthread_preempts_current(woken))
+			*higher_priority_woken = 1;
+
+		if (interrupts)
+			PORT_ENABLE_INTERRUPTS();
+	}
+
+	return written;
+}
+
+size_t
+kstream_read(struct kstream_t *stream, void *data, size_t size,
+	     kticktype_t tick_timeout)
+{
+	int interrupts;
+	size_t available, i;
+	port_atomic_index_t read_index;
+	struct kthread_t *current;
+	uint8_t *bytes;
+
+	if (!stream || !data || !size)
+		return 0;
+
+	available = kstream_available(stream);
+	if (available < size && available < stream->trigger_level &&
+	    tick_timeout != 0) {
+		interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+		if (interrupts)
+			PORT_DISABLE_INTERRUPTS();
+
+		/* checked again because the writer may have written since */
+		current = kthread_current();
+		available = kstream_available(stream);
+		if (current && available < size &&
+		    available < stream->trigger_level) {
+			stream->wanted = (port_atomic_index_t)
+					 (size < stream->trigger_level ?
+					  size : stream->trigger_level);
+			(void)kthread_block((struct kthread_t **)
+					    &stream->reader, tick_timeout);
+		}
+
+		if (interrupts)
+			PORT_ENABLE_INTERRUPTS();
+
+		available = kstream_available(stream);
+	}
+
+	if (size > available)
+		size = available;
+
+	bytes = data;
+	read_index = stream->read_index;
+	for (i = 0; i < size; i++) {
+		bytes[i] = stream->buffer[read_index & stream->mask];
+		read_index++;
+	}
+	/* the bytes were copied out before the writer can reuse their place */
+	stream->read_index = read_index;
+
+	return size;
+}
+
+size_t
+kstream_available(struct kstream_t *stream)
+{
+	if (!stream)
+		return 0;
+
+	return (port_atomic_index_t)(stream->write_index -
+				     stream->read_index);
+}
+
+/**
+ * This is a internal function that copies as many bytes of data as fit into
+ * the stream and then publishes them by updating the write index
+ */
+static size_t
+kstream_copy_in(struct kstream_t *stream, const void *data, size_t size)
+{
+	size_t space, i;
+	port_atomic_index_t write_index;
+	const uint8_t *bytes;
+
+	space = (size_t)stream->mask + 1 - kstream_available(stream);
+	if (size > space)
+		size = space;
+
+	bytes = data;
+	write_index = stream->write_index;
+	for (i = 0; i < size; i++) {
+		stream->buffer[write_index & stream->mask] = bytes[i];
+		write_index++;
+	}
+	stream->write_index = write_index;
+
+	return size;
+}
+
+/**
+ * This is a internal function that wakes the reader if enough bytes are
+ * available for it. It must be called with interrupts disabled
+ *
+ * @returns The reader if it was woken and NULL otherwise
+ */
+static struct kthread_t *
+kstream_wake_reader(struct kstream_t *stream)
+{
+	struct kthread_t *reader;
+
+	reader = stream->reader;
+	if (!reader || kstream_available(stream) < stream->wanted)
+		return NULL;
+
+	kthread_wake(reader, KWAIT_SUCCESS);
+
+	return reader;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#include <static_rtos/kernel/trace.h>
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+#include "internal.h"
+
+#ifdef STATIC_RTOS_TRACE
+
+static struct ktrace_record_t *ktrace_buffer; /**< NULL while not tracing */
+static uint32_t ktrace_capacity;
+static uint32_t ktrace_written; /**< counts up and wraps around, the capacity
+				 **< is a power of two so the index stays right
+				 */
+
+/* function definitions */
+
+int
+ktrace_start(struct ktrace_record_t *buffer, size_t capacity)
+{
+	int interrupts;
+
+	if (!buffer || capacity == 0 || (capacity & (capacity - 1)))
+		return 1;
+
+	/* the written count wraps around at 32 bits */
+	if ((size_t)(uint32_t)capacity != capacity)
+		return 1;
+
+	port_timestamp_start();
+
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	ktrace_capacity = (uint32_t)capacity;
+	ktrace_written = 0;
+	ktrace_buffer = buffer;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+void
+ktrace_stop(void)
+{
+	ktrace_buffer = NULL;
+}
+
+void
+ktrace_get_header(struct ktrace_header_t *header)
+{
+	header->magic = KTRACE_MAGIC;
+	header->timestamp_hz = PORT_TIMESTAMP_HZ;
+	header->capacity = ktrace_capacity;
+	header->written = ktrace_written;
+}
+
+void
+ktrace_user(uint16_t arg)
+{
+	ktrace_record(KTRACE_USER, kcurrent_thread_id, arg);
+}
+
+void
+ktrace_record(uint8_t event, int thread, uint16_t arg)
+{
+	struct ktrace_record_t *record;
+	int interrupts;
+
+	if (!ktrace_buffer)
+		return;
+
+	/* a isr must not take the same record */
+	interrupts = PORT_ARE_INTERRUPTS_ENABLED();
+	if (interrupts)
+		PORT_DISABLE_INTERRUPTS();
+
+	record = &ktrace_buffer[ktrace_written & (ktrace_capacity - 1)];
+	ktrace_written++;
+	record->timestamp = port_timestamp();
+	record->event = event;
+	record->thread = (uint8_t)thread;
+	record->arg = arg;
+
+	if (interrupts)
+		PORT_ENABLE_INTERRUPTS();
+}
+
+#endif /* #ifdef STATIC_RTOS_TRACE */
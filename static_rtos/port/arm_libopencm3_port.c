@@ -1,9 +1,12 @@
 #include <stddef.h>
 
+#include <static_rtos/kernel/scheduler.h>
 #include <static_rtos/port/port.h>
 
 #include <libopencm3/cm3/cortex.h>
 #include <libopencm3/cm3/systick.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/scb.h>
 
 static void port_makecontext_callfunc(void (*func)(void *), void *args,
 				      mcu_context_t *successor_cp);
@@ -124,6 +127,11 @@ port_enable_tick_interrupt(void)
 	/* on startup, the systick counter value is unknown */
 	systick_clear();
 
+	/* the switches requested by isrs happen in PendSV, after every other
+	 * isr is done
+	 */
+	nvic_set_priority(NVIC_PENDSV_IRQ, 0xff);
+
 	systick_interrupt_enable();
 
 	/* Start counting. */
@@ -132,6 +140,56 @@ port_enable_tick_interrupt(void)
 	return 0;
 }
 
+void
+port_idle(void)
+{
+	/* primask stays set so wfi returns on any pending interrupt, then the
+	 * interrupt is let in
+	 */
+	cm_enable_faults();
+	__asm__ __volatile__("dsb\n\twfi\n\tisb\n");
+	cm_enable_interrupts();
+	__asm__ __volatile__("isb\n");
+	cm_disable_interrupts();
+	cm_disable_faults();
+}
+
+void
+port_request_switch(void)
+{
+	SCB_ICSR = SCB_ICSR_PENDSVSET;
+}
+
+/**
+ * PendSV has the lowest priority, so it runs once no other isr is active
+ */
+void
+pend_sv_handler(void)
+{
+	kyield();
+}
+
+int
+port_atomic_cas_int(volatile int *ptr, int expected, int desired)
+{
+	int value;
+	uint32_t failed;
+
+	do {
+		__asm__ volatile("ldrex %0, [%1]" : "=r" (value) : "r" (ptr));
+		if (value != expected) {
+			__asm__ volatile("clrex" ::: "memory");
+			return 0;
+		}
+		/* strex fails if a exception came after the ldrex */
+		__asm__ volatile("strex %0, %2, [%1]"
+				 : "=&r" (failed) : "r" (ptr), "r" (desired)
+				 : "memory");
+	} while (failed);
+
+	return 1;
+}
+
 /**
  * NOTE: for the cm3 port, this function enables both interrupts and faults
  */
@@ -44,6 +44,8 @@ In general, you should include it only once across the project.
 #include <stdio.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <static_rtos/kernel/scheduler.h>
 #include <static_rtos/port/port.h>
 
 #ifdef __AVR__
@@ -170,6 +172,46 @@ port_enable_tick_interrupt(void)
 	return 0;
 }
 
+void
+port_idle(void)
+{
+	/* the instruction after sei always runs before a interrupt, so the
+	 * interrupt wakes the cpu up instead of coming before the sleep
+	 */
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	cli();
+}
+
+void
+port_request_switch(void)
+{
+	/* isrs don't nest on the avr, so the switch is done right away */
+	kyield();
+}
+
+int
+port_atomic_cas_int(volatile int *ptr, int expected, int desired)
+{
+	uint8_t sreg;
+	int ret;
+
+	/* a int takes two loads and two stores, so interrupts are disabled
+	 * around them and then set back to what they were
+	 */
+	sreg = SREG;
+	cli();
+	ret = *ptr == expected;
+	if (ret)
+		*ptr = desired;
+	SREG = sreg;
+
+	return ret;
+}
+
 int
 PORT_ENABLE_INTERRUPTS(void)
 {
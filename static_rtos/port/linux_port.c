@@ -0,0 +1,331 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+#ifdef STATIC_RTOS_LINUX_FAST_CONTEXT
+
+/* offsets of the fields of struct linux_context_t */
+#define CONTEXT_ASM_OFFSETS \
+	".equ CTX_RBX, 0\n" \
+	".equ CTX_RBP, 8\n" \
+	".equ CTX_R12, 16\n" \
+	".equ CTX_R13, 24\n" \
+	".equ CTX_R14, 32\n" \
+	".equ CTX_R15, 40\n" \
+	".equ CTX_RSP, 48\n" \
+	".equ CTX_RIP, 56\n" \
+	".equ CTX_MXCSR, 64\n" \
+	".equ CTX_FPUCW, 68\n"
+
+/* saves the context into the structure pointed to by rdi. The saved rip and
+ * rsp are the ones the caller will have after the call returns
+ */
+#define CONTEXT_ASM_SAVE_RDI \
+	"	movq %rbx, CTX_RBX(%rdi)\n" \
+	"	movq %rbp, CTX_RBP(%rdi)\n" \
+	"	movq %r12, CTX_R12(%rdi)\n" \
+	"	movq %r13, CTX_R13(%rdi)\n" \
+	"	movq %r14, CTX_R14(%rdi)\n" \
+	"	movq %r15, CTX_R15(%rdi)\n" \
+	"	leaq 8(%rsp), %rax\n" \
+	"	movq %rax, CTX_RSP(%rdi)\n" \
+	"	movq (%rsp), %rax\n" \
+	"	movq %rax, CTX_RIP(%rdi)\n" \
+	"	stmxcsr CTX_MXCSR(%rdi)\n" \
+	"	fnstcw CTX_FPUCW(%rdi)\n"
+
+/* loads the context from the structure pointed to by the register R and
+ * jumps to it with 0 as the return value
+ */
+#define CONTEXT_ASM_LOAD(R) \
+	"	movq CTX_RBX(" R "), %rbx\n" \
+	"	movq CTX_RBP(" R "), %rbp\n" \
+	"	movq CTX_R12(" R "), %r12\n" \
+	"	movq CTX_R13(" R "), %r13\n" \
+	"	movq CTX_R14(" R "), %r14\n" \
+	"	movq CTX_R15(" R "), %r15\n" \
+	"	ldmxcsr CTX_MXCSR(" R ")\n" \
+	"	fldcw CTX_FPUCW(" R ")\n" \
+	"	movq CTX_RSP(" R "), %rsp\n" \
+	"	xorl %eax, %eax\n" \
+	"	jmp *CTX_RIP(" R ")\n"
+
+void port_makecontext_callfunc(void (*func)(void *), void *args,
+			       const mcu_context_t *successor_cp);
+void port_makecontext_start(void);
+
+__asm__(
+	CONTEXT_ASM_OFFSETS
+	"	.text\n"
+	"	.globl port_getcontext\n"
+	"	.type port_getcontext, @function\n"
+	"port_getcontext:\n"
+	CONTEXT_ASM_SAVE_RDI
+	"	xorl %eax, %eax\n"
+	"	ret\n"
+	"	.size port_getcontext, .-port_getcontext\n"
+
+	"	.globl port_setcontext\n"
+	"	.type port_setcontext, @function\n"
+	"port_setcontext:\n"
+	CONTEXT_ASM_LOAD("%rdi")
+	"	.size port_setcontext, .-port_setcontext\n"
+
+	"	.globl port_swapcontext\n"
+	"	.type port_swapcontext, @function\n"
+	"port_swapcontext:\n"
+	CONTEXT_ASM_SAVE_RDI
+	CONTEXT_ASM_LOAD("%rsi")
+	"	.size port_swapcontext, .-port_swapcontext\n"
+
+	/* first code a new context runs: r12, r13 and r14 are set up by
+	 * port_makecontext and the stack is 16 byte aligned
+	 */
+	"	.globl port_makecontext_start\n"
+	"	.type port_makecontext_start, @function\n"
+	"port_makecontext_start:\n"
+	"	movq %r12, %rdi\n"
+	"	movq %r13, %rsi\n"
+	"	movq %r14, %rdx\n"
+	"	call port_makecontext_callfunc\n"
+	"	ud2\n"
+	"	.size port_makecontext_start, .-port_makecontext_start\n"
+);
+
+#else /* #ifdef STATIC_RTOS_LINUX_FAST_CONTEXT */
+
+#define PTR_HIGH(P) ((unsigned int)((uintptr_t)(P) >> 16 >> 16))
+#define PTR_LOW(P) ((unsigned int)(uintptr_t)(P))
+#define PTR_JOIN(H, L) (((uintptr_t)(H) << 16 << 16) | (uintptr_t)(L))
+
+static void port_makecontext_callfunc(unsigned int func_high,
+				      unsigned int func_low,
+				      unsigned int args_high,
+				      unsigned int args_low);
+
+#endif /* #ifdef STATIC_RTOS_LINUX_FAST_CONTEXT */
+
+static volatile sig_atomic_t interrupts_disabled; /**< set while interrupts
+						   **< are disabled
+						   */
+/* the amount of different isrs that can be pending at the same time */
+#define PENDING_ISRS 4
+
+static void (*volatile pending_isrs[PENDING_ISRS])(void); /**< isrs of the
+						**< signals that came while
+						**< interrupts were disabled
+						*/
+
+#ifdef STATIC_RTOS_LINUX_FAST_CONTEXT
+
+int
+port_makecontext(mcu_context_t *cp, void *stackp, const size_t stack_size,
+		 const mcu_context_t *successor_cp, void (*funcp)(void *),
+		 void *funcargp)
+{
+	/* the mxcsr and fpucw fields were filled in by port_getcontext */
+	cp->r12 = (uint64_t)(uintptr_t)funcp;
+	cp->r13 = (uint64_t)(uintptr_t)funcargp;
+	cp->r14 = (uint64_t)(uintptr_t)successor_cp;
+	cp->rsp = ((uint64_t)(uintptr_t)stackp + stack_size) & ~(uint64_t)15;
+	cp->rip = (uint64_t)(uintptr_t)port_makecontext_start;
+
+	return 0;
+}
+
+#else /* #ifdef STATIC_RTOS_LINUX_FAST_CONTEXT */
+
+int
+port_makecontext(mcu_context_t *cp, void *stackp, const size_t stack_size,
+		 const mcu_context_t *successor_cp, void (*funcp)(void *),
+		 void *funcargp)
+{
+	cp->uc_stack.ss_sp = stackp;
+	cp->uc_stack.ss_size = stack_size;
+	cp->uc_link = (mcu_context_t *)successor_cp;
+
+	/* makecontext only passes int arguments, so the pointers are split */
+	makecontext(cp, (void (*)(void))port_makecontext_callfunc, 4,
+		    PTR_HIGH(funcp), PTR_LOW(funcp),
+		    PTR_HIGH(funcargp), PTR_LOW(funcargp));
+
+	return 0;
+}
+
+#endif /* #ifdef STATIC_RTOS_LINUX_FAST_CONTEXT */
+
+void
+port_linux_raise_interrupt(void (*isr)(void))
+{
+	void (*expected)(void);
+	int i;
+
+	if (interrupts_disabled) {
+		/* a signal can interrupt this loop, so slots are claimed with
+		 * a compare and swap. A isr that is already pending stays
+		 * pending once, like a interrupt flag
+		 */
+		for (i = 0; i < PENDING_ISRS; i++) {
+			expected = NULL;
+			if (__atomic_compare_exchange_n(&pending_isrs[i],
+							&expected, isr, 0,
+							__ATOMIC_SEQ_CST,
+							__ATOMIC_SEQ_CST) ||
+			    expected == isr)
+				return;
+		}
+		return;
+	}
+
+	interrupts_disabled = 1;
+	isr();
+	PORT_ENABLE_INTERRUPTS();
+}
+
+int
+port_linux_is_interrupt_pending(void)
+{
+	int i;
+
+	for (i = 0; i < PENDING_ISRS; i++) {
+		if (pending_isrs[i])
+			return 1;
+	}
+
+	return 0;
+}
+
+void
+port_idle(void)
+{
+	sigset_t all_set, old_set;
+
+	/* with the signals blocked, none can come between checking for a
+	 * pending isr and sigsuspend, which unblocks them and waits atomically.
+	 * A isr that is already pending runs when the caller enables
+	 * interrupts, with the signals unblocked, since it may switch threads
+	 */
+	sigfillset(&all_set);
+	sigprocmask(SIG_BLOCK, &all_set, &old_set);
+	if (!port_linux_is_interrupt_pending()) {
+		PORT_ENABLE_INTERRUPTS();
+		sigsuspend(&old_set);
+		PORT_DISABLE_INTERRUPTS();
+	}
+	sigprocmask(SIG_SETMASK, &old_set, NULL);
+}
+
+/**
+ * The simulated isrs don't nest and run on the stack of the interrupted thread,
+ * so the switch kisr_exit asks for is done right away
+ */
+void
+port_request_switch(void)
+{
+	kyield();
+}
+
+/**
+ * All threads and the simulated isrs run on one host thread, so the compare and
+ * store only needs to be a single instruction that a signal can't split, not a
+ * bus locked one
+ */
+int
+port_atomic_cas_int(volatile int *ptr, int expected, int desired)
+{
+#ifdef __x86_64__
+	unsigned char ret;
+
+	__asm__ volatile("cmpxchgl %3, %1\n\tsete %0"
+			 : "=q" (ret), "+m" (*ptr), "+a" (expected)
+			 : "r" (desired)
+			 : "memory", "cc");
+
+	return ret;
+#else
+	return __atomic_compare_exchange_n(ptr, &expected, desired, 0,
+					   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+int
+PORT_ENABLE_INTERRUPTS(void)
+{
+	void (*isr)(void);
+	int i;
+
+	interrupts_disabled = 0;
+
+	/* a signal that comes from now on runs its isr right away, so only
+	 * the ones that were left pending need to run here
+	 */
+	for (i = 0; i < PENDING_ISRS; i++) {
+		isr = __atomic_exchange_n(&pending_isrs[i], NULL,
+					  __ATOMIC_SEQ_CST);
+		if (isr)
+			port_linux_raise_interrupt(isr);
+	}
+
+	return 0;
+}
+
+int
+PORT_DISABLE_INTERRUPTS(void)
+{
+	interrupts_disabled = 1;
+	return 0;
+}
+
+int
+PORT_ARE_INTERRUPTS_ENABLED(void)
+{
+	return !interrupts_disabled;
+}
+
+#ifdef STATIC_RTOS_LINUX_FAST_CONTEXT
+
+/**
+ * Internal helper function for port_makecontext, called from
+ * port_makecontext_start. Threads are switched to with interrupts disabled, so
+ * a new thread enables them before starting
+ */
+void
+port_makecontext_callfunc(void (*func)(void *), void *args,
+			  const mcu_context_t *successor_cp)
+{
+	PORT_ENABLE_INTERRUPTS();
+	func(args);
+	port_setcontext(successor_cp);
+}
+
+#else /* #ifdef STATIC_RTOS_LINUX_FAST_CONTEXT */
+
+/**
+ * Internal helper function for port_makecontext. Threads are switched to with
+ * interrupts disabled, so a new thread enables them before starting
+ */
+static void
+port_makecontext_callfunc(unsigned int func_high, unsigned int func_low,
+			  unsigned int args_high, unsigned int args_low)
+{
+	void (*func)(void *);
+
+	func = (void (*)(void *))PTR_JOIN(func_high, func_low);
+
+	PORT_ENABLE_INTERRUPTS();
+	func((void *)PTR_JOIN(args_high, args_low));
+}
+
+#endif /* #ifdef STATIC_RTOS_LINUX_FAST_CONTEXT */
+
+/* TODO: make this into a .c file */
+#include "avr_libopencm3_common.h"
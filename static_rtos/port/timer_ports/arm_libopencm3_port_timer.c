@@ -3,14 +3,108 @@
 #include <libopencm3/cm3/cortex.h>
 #include <libopencm3/cm3/systick.h>
 #include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/scb.h>
+#include <libopencm3/cm3/dwt.h>
+
+/* NOTE: same clock as in port_enable_tick_interrupt, 72MHz / 8 / 1000 */
+#define SYSTICK_COUNTS_PER_TICK 9000
+/* the systick counter has 24 bits */
+#define TICKLESS_MAX_TICKS (0xffffff / SYSTICK_COUNTS_PER_TICK)
+
+static volatile uint8_t tickless_active; /**< set while the tick is
+					  **< suppressed
+					  */
+static volatile uint8_t tickless_expired; /**< set by the isr if the timer
+					   **< expired while the tick was
+					   **< suppressed
+					   */
 
 void
 sys_tick_handler(void)
 {
+	if (tickless_active) {
+		tickless_expired = 1;
+		return;
+	}
+
 	if (!kscheduler_has_started())
 		return;
-	
-	if (kincrease_tickcount())
-		kyield();
+
+	/* the switch, if a thread should preempt, happens in kisr_exit */
+	kisr_enter();
+	kincrease_tickcount();
+	kisr_exit();
+}
+
+uint16_t
+port_suppress_ticks_and_sleep(uint16_t ticks_count)
+{
+	uint32_t remaining, programmed, counts, elapsed;
+
+	/* a tick that is already pending must be counted normally */
+	if (ticks_count == 0 || (SCB_ICSR & SCB_ICSR_PENDSTSET))
+		return 0;
+	if (ticks_count > TICKLESS_MAX_TICKS)
+		ticks_count = TICKLESS_MAX_TICKS;
+
+	/* the counts left in the current tick plus the whole ticks after it */
+	systick_counter_disable();
+	remaining = systick_get_value();
+	if (remaining == 0)
+		remaining = 1;
+	programmed = remaining + (ticks_count - 1) * SYSTICK_COUNTS_PER_TICK;
+	systick_set_reload(programmed - 1);
+	systick_clear();
+	tickless_expired = 0;
+	tickless_active = 1;
+	systick_counter_enable();
+
+	/* primask stays set so wfi returns on any pending interrupt, then the
+	 * interrupt is let in
+	 */
+	cm_enable_faults();
+	__asm__ __volatile__("dsb\n\twfi\n\tisb\n");
+	cm_enable_interrupts();
+	__asm__ __volatile__("isb\n");
+	cm_disable_interrupts();
+	cm_disable_faults();
+
+	systick_counter_disable();
+	tickless_active = 0;
+
+	/* after expiring, the counter started over from programmed */
+	counts = programmed - systick_get_value();
+	if (tickless_expired) {
+		elapsed = ticks_count + counts / SYSTICK_COUNTS_PER_TICK;
+	} else {
+		counts += SYSTICK_COUNTS_PER_TICK - remaining;
+		elapsed = counts / SYSTICK_COUNTS_PER_TICK;
+	}
+
+	/* the next tick comes at the next tick boundary, after it the period
+	 * goes back to normal
+	 */
+	counts %= SYSTICK_COUNTS_PER_TICK;
+	systick_set_reload(SYSTICK_COUNTS_PER_TICK - counts - 1);
+	systick_clear();
+	systick_counter_enable();
+	systick_set_reload(SYSTICK_COUNTS_PER_TICK - 1);
+
+	return elapsed;
+}
+
+#if defined(STATIC_RTOS_TRACE) || defined(STATIC_RTOS_THREAD_STATS)
+
+void
+port_timestamp_start(void)
+{
+	dwt_enable_cycle_counter();
+}
+
+uint32_t
+port_timestamp(void)
+{
+	return dwt_read_cycle_counter();
 }
 
+#endif /* #if defined(STATIC_RTOS_TRACE) || ... */
@@ -9,15 +9,114 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+/* the longest period timer1 can measure from the start of a tick */
+#define TICKLESS_MAX_TICKS (TCNT1_1MS / TCNT1_COUNTS_PER_TICK)
+
+static volatile uint8_t tickless_active; /**< set while the tick is
+					  **< suppressed
+					  */
+static volatile uint8_t tickless_expired; /**< set by the isr if the timer
+					   **< overflowed while the tick was
+					   **< suppressed
+					   */
 
 ISR(TIMER1_OVF_vect)
 {
 	TCNT1 = TCNT1_1MS;
 
+	if (tickless_active) {
+		tickless_expired = 1;
+		return;
+	}
+
 	if (!kscheduler_has_started())
 		return;
-	
-	if (kincrease_tickcount())
-		kyield();
+
+	/* the switch, if a thread should preempt, happens in kisr_exit */
+	kisr_enter();
+	kincrease_tickcount();
+	kisr_exit();
+}
+
+uint16_t
+port_suppress_ticks_and_sleep(uint16_t ticks_count)
+{
+	uint16_t start, programmed, counts;
+
+	/* a tick that is already pending must be counted normally */
+	if (ticks_count == 0 || (TIFR1 & (1 << TOV1)))
+		return 0;
+	if (ticks_count > TICKLESS_MAX_TICKS)
+		ticks_count = TICKLESS_MAX_TICKS;
+
+	/* the current tick ends when timer1 overflows, so it is enough to
+	 * move the counter back by the remaining ticks
+	 */
+	start = TCNT1;
+	programmed = start - (ticks_count - 1) * TCNT1_COUNTS_PER_TICK;
+	TCNT1 = programmed;
+	tickless_expired = 0;
+	tickless_active = 1;
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	cli();
+
+	tickless_active = 0;
+	if (tickless_expired)
+		return ticks_count;
+
+	/* woken up early by another interrupt: count the whole ticks that
+	 * passed and keep the next overflow on the tick boundary
+	 */
+	counts = (TCNT1 - programmed) + (start - TCNT1_1MS);
+	TCNT1 = TCNT1_1MS + counts % TCNT1_COUNTS_PER_TICK;
+
+	return counts / TCNT1_COUNTS_PER_TICK;
+}
+
+#if defined(STATIC_RTOS_TRACE) || defined(STATIC_RTOS_THREAD_STATS)
+
+void
+port_timestamp_start(void)
+{
+}
+
+/**
+ * NOTE: while the tick is suppressed, the timestamps don't count the ticks that
+ * haven't been added to the tick count yet
+ */
+uint32_t
+port_timestamp(void)
+{
+	uint8_t sreg;
+	uint16_t counts;
+	uint32_t ticks;
+
+	sreg = SREG;
+	cli();
+
+	counts = TCNT1 - TCNT1_1MS;
+	ticks = kget_tickcount();
+	/* the overflow of this tick came but its isr didn't run yet, so the
+	 * tick isn't in the tick count. timer1 wrapped around to 0 instead of
+	 * starting at TCNT1_1MS, so it counts from the end of that tick. It is
+	 * read again because the overflow may have come right after the read
+	 * above
+	 */
+	if (TIFR1 & (1 << TOV1)) {
+		ticks++;
+		counts = TCNT1;
+	}
+
+	SREG = sreg;
+
+	return ticks * TCNT1_COUNTS_PER_TICK + counts;
 }
 
+#endif /* #if defined(STATIC_RTOS_TRACE) || ... */
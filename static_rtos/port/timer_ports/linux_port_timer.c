@@ -0,0 +1,193 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <static_rtos/kernel/scheduler.h>
+#include <static_rtos/port/port.h>
+
+/* the tick period can be changed with -DSTATIC_RTOS_LINUX_TICK_NS=N */
+#ifndef STATIC_RTOS_LINUX_TICK_NS
+#define STATIC_RTOS_LINUX_TICK_NS 1000000L
+#endif
+
+static void tick_isr(void);
+static void tick_signal_handler(int sig);
+static int64_t timespec_to_ns(const struct timespec *ts);
+static void ns_to_timespec(int64_t ns, struct timespec *ts);
+
+volatile unsigned long port_linux_tick_interrupts;
+
+static timer_t tick_timer;
+static volatile sig_atomic_t tickless_active; /**< set while the tick is
+					       **< suppressed
+					       */
+static volatile sig_atomic_t tickless_expired; /**< set by the isr if the
+						**< timer expired while the
+						**< tick was suppressed
+						*/
+
+int
+port_enable_tick_interrupt(void)
+{
+	struct sigaction sa;
+	struct sigevent sev;
+	struct itimerspec its;
+
+	/* SA_NODEFER: the signal isn't blocked while its handler runs because
+	 * the handler may switch to another thread and never return to the
+	 * kernel. Nesting is prevented by the interrupt flag instead
+	 */
+	sa.sa_handler = tick_signal_handler;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_NODEFER | SA_RESTART;
+	if (sigaction(SIGALRM, &sa, NULL))
+		return 1;
+
+	sev.sigev_notify = SIGEV_SIGNAL;
+	sev.sigev_signo = SIGALRM;
+	sev.sigev_value.sival_ptr = NULL;
+	if (timer_create(CLOCK_MONOTONIC, &sev, &tick_timer))
+		return 1;
+
+	ns_to_timespec(STATIC_RTOS_LINUX_TICK_NS, &its.it_value);
+	ns_to_timespec(STATIC_RTOS_LINUX_TICK_NS, &its.it_interval);
+	if (timer_settime(tick_timer, 0, &its, NULL))
+		return 1;
+
+	PORT_ENABLE_INTERRUPTS();
+
+	return 0;
+}
+
+uint16_t
+port_suppress_ticks_and_sleep(uint16_t ticks_count)
+{
+	struct itimerspec its;
+	struct timespec start, now;
+	sigset_t all_set, old_set;
+	int64_t into_tick, elapsed;
+
+	/* a tick that is already pending must be counted normally */
+	if (ticks_count == 0 || port_linux_is_interrupt_pending())
+		return 0;
+
+	/* program a one-shot that ends where the ticks_count-th tick would */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	timer_gettime(tick_timer, &its);
+	into_tick = STATIC_RTOS_LINUX_TICK_NS - timespec_to_ns(&its.it_value);
+	ns_to_timespec((int64_t)ticks_count * STATIC_RTOS_LINUX_TICK_NS -
+		       into_tick, &its.it_value);
+	ns_to_timespec(0, &its.it_interval);
+	tickless_expired = 0;
+	tickless_active = 1;
+	timer_settime(tick_timer, 0, &its, NULL);
+
+	/* like in port_idle, with every signal blocked none can come between
+	 * the checks and sigsuspend, which unblocks them and waits atomically.
+	 * A isr that became pending while the one-shot was programmed, or a
+	 * thread that is READY, ends the sleep before it starts. Interrupts
+	 * stay disabled: the isr of a signal that ends the sleep is left
+	 * pending and runs when the caller enables interrupts, with the
+	 * signals unblocked and the periodic tick running again, since it may
+	 * switch threads
+	 */
+	sigfillset(&all_set);
+	sigprocmask(SIG_BLOCK, &all_set, &old_set);
+	if (!tickless_expired && !port_linux_is_interrupt_pending() &&
+	    !kscheduler_has_ready_thread())
+		sigsuspend(&old_set);
+	sigprocmask(SIG_SETMASK, &old_set, NULL);
+	tickless_active = 0;
+
+	/* count the whole ticks that passed and restart the periodic tick on
+	 * the tick boundary
+	 */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = timespec_to_ns(&now) - timespec_to_ns(&start) + into_tick;
+	ns_to_timespec(STATIC_RTOS_LINUX_TICK_NS -
+		       elapsed % STATIC_RTOS_LINUX_TICK_NS, &its.it_value);
+	ns_to_timespec(STATIC_RTOS_LINUX_TICK_NS, &its.it_interval);
+	timer_settime(tick_timer, 0, &its, NULL);
+
+	elapsed /= STATIC_RTOS_LINUX_TICK_NS;
+
+	return elapsed > UINT16_MAX ? UINT16_MAX : elapsed;
+}
+
+#if defined(STATIC_RTOS_TRACE) || defined(STATIC_RTOS_THREAD_STATS)
+
+void
+port_timestamp_start(void)
+{
+}
+
+uint32_t
+port_timestamp(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint32_t)timespec_to_ns(&ts);
+}
+
+#endif /* #if defined(STATIC_RTOS_TRACE) || ... */
+
+/**
+ * The tick isr. It runs with interrupts disabled
+ */
+static void
+tick_isr(void)
+{
+	port_linux_tick_interrupts++;
+
+	if (!kscheduler_has_started())
+		return;
+
+	/* the switch, if a thread should preempt, happens in kisr_exit */
+	kisr_enter();
+	kincrease_tickcount();
+	kisr_exit();
+}
+
+static void
+tick_signal_handler(int sig)
+{
+	int saved_errno;
+
+	(void)sig;
+
+	/* the one-shot of a suppressed tick only ends the sleep, the ticks it
+	 * covered are counted by port_suppress_ticks_and_sleep, so no tick
+	 * isr is left pending for it
+	 */
+	if (tickless_active) {
+		port_linux_tick_interrupts++;
+		tickless_expired = 1;
+		return;
+	}
+
+	saved_errno = errno;
+	port_linux_raise_interrupt(tick_isr);
+	errno = saved_errno;
+}
+
+static int64_t
+timespec_to_ns(const struct timespec *ts)
+{
+	return (int64_t)ts->tv_sec * 1000000000 + ts->tv_nsec;
+}
+
+static void
+ns_to_timespec(int64_t ns, struct timespec *ts)
+{
+	ts->tv_sec = ns / 1000000000;
+	ts->tv_nsec = ns % 1000000000;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2024 Timothy Joseph. Subject to MIT license
+ * See LICENSE.txt for details
+ */
+
+/*
+ * Converts a trace dump (a struct ktrace_header_t followed by the ring buffer,
+ * see static_rtos/kernel/trace.h) into the Chrome trace event format, which
+ * chrome://tracing and ui.perfetto.dev show as a timeline:
+ *
+ * ./trace_decode dump.bin > trace.json
+ *
+ * Every thread is a row where it is shown running between the switches to it
+ * and away from it, isrs are slices on their own row and the other events are
+ * instant events on the row of their thread. Dumps from targets with the other
+ * byte order are swapped
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <static_rtos/kernel/trace.h>
+
+/* the row of the isrs, above every thread id */
+#define ISR_ROW 256
+#define ROWS (ISR_ROW + 1)
+
+static uint32_t swap32(uint32_t x);
+static uint16_t swap16(uint16_t x);
+static void print_event(const char *phase, const char *name, int row,
+			double us, int has_arg, unsigned int arg);
+static void print_row_name(int row);
+
+static const char *event_names[] = {
+	"switch", "ready", "suspend", "sleep", "tick", "isr enter", "isr exit",
+	"block", "wake", "priority", "user"
+};
+
+static int first_event = 1;
+
+static uint32_t
+swap32(uint32_t x)
+{
+	return (x >> 24) | ((x >> 8) & 0xff00) | ((x << 8) & 0xff0000) |
+	       (x << 24);
+}
+
+static uint16_t
+swap16(uint16_t x)
+{
+	return (uint16_t)((x >> 8) | (x << 8));
+}
+
+static void
+print_event(const char *phase, const char *name, int row, double us,
+	    int has_arg, unsigned int arg)
+{
+	printf("%s\n{\"ph\":\"%s\",\"name\":\"%s\",\"pid\":0,\"tid\":%d,"
+	       "\"ts\":%.3f", first_event ? "" : ",", phase, name, row, us);
+	if (*phase == 'i')
+		printf(",\"s\":\"t\"");
+	if (has_arg)
+		printf(",\"args\":{\"arg\":%u}", arg);
+	printf("}");
+	first_event = 0;
+}
+
+static void
+print_row_name(int row)
+{
+	printf("%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,"
+	       "\"tid\":%d,\"args\":{\"name\":\"", first_event ? "" : ",", row);
+	if (row == ISR_ROW)
+		printf("isr");
+	else if (row == 0)
+		printf("scheduler");
+	else
+		printf("thread %d", row);
+	printf("\"}}");
+	first_event = 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	static int open_slices[ROWS];
+	static int seen[ROWS];
+	struct ktrace_header_t header;
+	struct ktrace_record_t *records, *record;
+	FILE *file;
+	uint32_t i, count, first, previous;
+	uint64_t ticks;
+	double us;
+	int swapped, row;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s dump.bin > trace.json\n", argv[0]);
+		return 1;
+	}
+
+	file = fopen(argv[1], "rb");
+	if (!file) {
+		perror(argv[1]);
+		return 1;
+	}
+	if (fread(&header, sizeof(header), 1, file) != 1) {
+		fprintf(stderr, "%s: no header\n", argv[1]);
+		return 1;
+	}
+
+	swapped = header.magic == swap32(KTRACE_MAGIC);
+	if (!swapped && header.magic != KTRACE_MAGIC) {
+		fprintf(stderr, "%s: not a trace dump\n", argv[1]);
+		return 1;
+	}
+	if (swapped) {
+		header.timestamp_hz = swap32(header.timestamp_hz);
+		header.capacity = swap32(header.capacity);
+		header.written = swap32(header.written);
+	}
+	if (header.capacity == 0 || header.timestamp_hz == 0) {
+		fprintf(stderr, "%s: bad header\n", argv[1]);
+		return 1;
+	}
+
+	records = malloc((size_t)header.capacity * sizeof(*records));
+	if (!records) {
+		perror("malloc");
+		return 1;
+	}
+	if (fread(records, sizeof(*records), header.capacity, file) !=
+	    header.capacity) {
+		fprintf(stderr, "%s: the buffer is cut short\n", argv[1]);
+		return 1;
+	}
+	fclose(file);
+
+	/* once the buffer is full, the oldest record is the next to write */
+	if (header.written > header.capacity) {
+		count = header.capacity;
+		first = header.written % header.capacity;
+	} else {
+		count = header.written;
+		first = 0;
+	}
+
+	printf("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	ticks = 0;
+	us = 0;
+	previous = 0;
+	for (i = 0; i < count; i++) {
+		record = &records[(first + i) % header.capacity];
+		if (swapped) {
+			record->timestamp = swap32(record->timestamp);
+			record->arg = swap16(record->arg);
+		}
+
+		/* the timestamps wrap around at 32 bits */
+		if (i > 0)
+			ticks += (uint32_t)(record->timestamp - previous);
+		previous = record->timestamp;
+		us = (double)ticks * 1000000 / header.timestamp_hz;
+
+		row = record->thread;
+		if (!seen[row]) {
+			print_row_name(row);
+			seen[row] = 1;
+		}
+
+		switch (record->event) {
+		case KTRACE_SWITCH:
+			if (open_slices[record->arg & 0xff]) {
+				print_event("E", "running", record->arg & 0xff,
+					    us, 0, 0);
+				open_slices[record->arg & 0xff]--;
+			}
+			print_event("B", "running", row, us, 0, 0);
+			open_slices[row]++;
+			break;
+		case KTRACE_ISR_ENTER:
+			if (!seen[ISR_ROW]) {
+				print_row_name(ISR_ROW);
+				seen[ISR_ROW] = 1;
+			}
+			print_event("B", "isr", ISR_ROW, us, 1, record->thread);
+			open_slices[ISR_ROW]++;
+			break;
+		case KTRACE_ISR_EXIT:
+			if (open_slices[ISR_ROW]) {
+				print_event("E", "isr", ISR_ROW, us, 0, 0);
+				open_slices[ISR_ROW]--;
+			}
+			break;
+		default:
+			if (record->event < sizeof(event_names) /
+					    sizeof(event_names[0]))
+				print_event("i", event_names[record->event],
+					    row, us, 1, record->arg);
+			else
+				print_event("i", "unknown", row, us, 1,
+					    record->arg);
+			break;
+		}
+	}
+
+	/* the slices still open end with the trace */
+	for (row = 0; row < ROWS; row++) {
+		while (open_slices[row]--)
+			print_event("E", row == ISR_ROW ? "isr" : "running",
+				    row, us, 0, 0);
+	}
+
+	printf("\n]}\n");
+	free(records);
+
+	return 0;
+}